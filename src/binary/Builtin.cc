@@ -52,18 +52,20 @@ static ScriptingAgent sa;
 
 extern "C" {
 
+  /*
+   * Calls builtin with the given parameters, the source location
+   * must be already set
+   */
   static VALUE call_builtin(const string &qualified_name, int argc, VALUE *argv)
   {
     extern StaticDeclaration static_declarations;
-    YaST::ee.setFilename(RSTRING_PTR(argv[0]));
-    YaST::ee.setLinenumber(FIX2INT(argv[1]));
 
     declaration_t *bi_dt = static_declarations.findDeclaration(qualified_name.c_str());
     if (bi_dt==NULL)
       rb_raise(rb_eNameError, "No such builtin '%s'", qualified_name.c_str());
 
     YEBuiltin bi_call(bi_dt);
-    for (int i = 3; i<argc; ++i)
+    for (int i = 0; i<argc; ++i)
     {
       YCPValue param_v = rbvalue_2_ycpvalue(argv[i]);
       YConstPtr param_c = new YConst(YCode::ycConstant, param_v);
@@ -82,26 +84,71 @@ extern "C" {
     if (err_tp != NULL)
       rb_raise(rb_eRuntimeError,"Error when finalizing builtin call: %s",err_tp->toString().c_str());
 
-    VALUE result = ycpvalue_2_rbvalue(bi_call.evaluate(false));
+    VALUE result = ycpvalue_2_rbvalue_result(bi_call.evaluate(false));
     return result;
   }
 
+  /*
+   * call_builtin(file, line, name, *args)
+   *
+   * Calls builtin of the namespace prefix (e.g. "SCR::"),
+   * file and line are the ruby source location of the call
+   */
   static VALUE
-  scr_call_builtin( int argc, VALUE *argv, VALUE self )
+  call_located_builtin( const char *prefix, int argc, VALUE *argv )
   {
     if (argc<3)
       rb_raise(rb_eArgError, "At least one argument must be passed");
-    std::string qualified_name = std::string("SCR::") + RSTRING_PTR(argv[2]);
-    return call_builtin(qualified_name,argc,argv);
+    YaST::ee.setFilename(RSTRING_PTR(argv[0]));
+    YaST::ee.setLinenumber(FIX2INT(argv[1]));
+    std::string qualified_name = std::string(prefix) + RSTRING_PTR(argv[2]);
+    return call_builtin(qualified_name,argc-3,argv+3);
   }
 
+  /*
+   * call_builtin_wrapper(name, *args)
+   *
+   * Like call_builtin, but the source location is found natively: it is
+   * the caller of the ruby function (e.g. SCR.Read) calling the wrapper
+   */
   static VALUE
-  wfm_call_builtin( int argc, VALUE *argv, VALUE self )
+  call_wrapped_builtin( const char *prefix, int argc, VALUE *argv )
   {
-    if (argc<3)
+    if (argc<1)
       rb_raise(rb_eArgError, "At least one argument must be passed");
-    std::string qualified_name = std::string("WFM::") + RSTRING_PTR(argv[2]);
-    return call_builtin(qualified_name,argc,argv);
+    std::string file;
+    int line;
+    if (y2ruby_caller_location(1, file, line))
+    {
+      YaST::ee.setFilename(file);
+      YaST::ee.setLinenumber(line);
+    }
+    std::string qualified_name = std::string(prefix) + StringValuePtr(argv[0]);
+    return call_builtin(qualified_name,argc-1,argv+1);
+  }
+
+  static VALUE
+  scr_call_builtin( int argc, VALUE *argv, VALUE self )
+  {
+    return call_located_builtin("SCR::", argc, argv);
+  }
+
+  static VALUE
+  wfm_call_builtin( int argc, VALUE *argv, VALUE self )
+  {
+    return call_located_builtin("WFM::", argc, argv);
+  }
+
+  static VALUE
+  scr_call_builtin_wrapper( int argc, VALUE *argv, VALUE self )
+  {
+    return call_wrapped_builtin("SCR::", argc, argv);
+  }
+
+  static VALUE
+  wfm_call_builtin_wrapper( int argc, VALUE *argv, VALUE self )
+  {
+    return call_wrapped_builtin("WFM::", argc, argv);
   }
 
   static bool recode(std::wstring &in, std::string &out)
@@ -699,8 +746,10 @@ extern "C"
     rb_define_singleton_method( rb_mYast, "strcoll", RUBY_METHOD_FUNC(strcoll_wrapper), 2);
     rb_mSCR = rb_define_module_under(rb_mYast, "SCR");
     rb_define_singleton_method( rb_mSCR, "call_builtin", RUBY_METHOD_FUNC(scr_call_builtin), -1);
+    rb_define_singleton_method( rb_mSCR, "call_builtin_wrapper", RUBY_METHOD_FUNC(scr_call_builtin_wrapper), -1);
     rb_mWFM = rb_define_module_under(rb_mYast, "WFM");
     rb_define_singleton_method( rb_mWFM, "call_builtin", RUBY_METHOD_FUNC(wfm_call_builtin), -1);
+    rb_define_singleton_method( rb_mWFM, "call_builtin_wrapper", RUBY_METHOD_FUNC(wfm_call_builtin_wrapper), -1);
     rb_mBuiltins = rb_define_module_under(rb_mYast, "Builtins");
     rb_mFloat = rb_define_module_under(rb_mBuiltins, "Float");
     rb_define_singleton_method( rb_mFloat, "tolstring", RUBY_METHOD_FUNC(float_to_lstring), 2);
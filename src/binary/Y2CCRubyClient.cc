@@ -1,5 +1,6 @@
 #include <unistd.h>
 #include "Y2CCRubyClient.h"
+#include "Y2RubyUtils.h"
 #include <ycp/pathsearch.h>
 #define y2log_component "Y2RubyClient"
 #include <ycp/y2log.h>
@@ -21,7 +22,8 @@ Y2Component *Y2CCRubyClient::create ( const char * name) const
 {
   y2debug("look for client with name %s", name);
   string sname(name);
-  string client_path = YCPPathSearch::find (YCPPathSearch::Client, sname + ".rb");
+  // remembered, the search found an existing file
+  string client_path = y2ruby_find_path (YCPPathSearch::Client, sname + ".rb");
   //client not found in form clients/<name>.rb
   if (client_path.empty())
   {
@@ -35,11 +37,11 @@ Y2Component *Y2CCRubyClient::create ( const char * name) const
 
     if (strlen(name) > 3 && strcmp(name + strlen(name) - 3, ".rb")) //not ruby file
       return NULL;
-  }
 
-  y2debug("test existence of file %s", client_path.c_str());
-  if (access(client_path.c_str(), R_OK) == -1) //no file or no read permission
-    return NULL;
+    y2debug("test existence of file %s", client_path.c_str());
+    if (access(client_path.c_str(), R_OK) == -1) //no file or no read permission
+      return NULL;
+  }
 
   Y2RubyClientComponent* rc = Y2RubyClientComponent::instance();
   rc->setClient(client_path);
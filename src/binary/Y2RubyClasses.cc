@@ -0,0 +1,115 @@
+/*---------------------------------------------------------------------\
+|                                                                      |
+|                      __   __    ____ _____ ____                      |
+|                      \ \ / /_ _/ ___|_   _|___ \                     |
+|                       \ V / _` \___ \ | |   __) |                    |
+|                        | | (_| |___) || |  / __/                     |
+|                        |_|\__,_|____/ |_| |_____|                    |
+|                                                                      |
+|                                                                      |
+| ruby language support                              (C) Novell Inc.   |
+\----------------------------------------------------------------------/
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version
+2 of the License, or (at your option) any later version.
+
+*/
+
+#define y2log_component "Y2Ruby"
+#include <ycp/y2log.h>
+
+#include "Y2RubyClasses.h"
+#include "Y2RubyUtils.h"
+
+struct y2ruby_class_entry
+{
+  //! file to require before the constant can be looked up
+  const char *feature;
+  //! constant name under the Yast module
+  const char *name;
+  //! resolved class, Qnil if not resolved (yet)
+  VALUE klass;
+  //! interned constant name, valid once the class is resolved
+  ID id;
+  //! revalidation epoch in which the class was last checked
+  unsigned long epoch;
+};
+
+static y2ruby_class_entry classes[Y2RUBY_CLASS_COUNT] =
+{
+  { "yast/path", "Path",       Qnil, 0, 0 },
+  { "yast/term", "Term",       Qnil, 0, 0 },
+  { "yastx",     "YReference", Qnil, 0, 0 },
+  { "yastx",     "Byteblock",  Qnil, 0, 0 },
+  { "yastx",     "YCode",      Qnil, 0, 0 },
+  { "yast",      "External",   Qnil, 0, 0 },
+  { "yast/lazy", "LazyList",   Qnil, 0, 0 },
+  { "yast/lazy", "LazyMap",    Qnil, 0, 0 },
+};
+
+static VALUE yast_module = Qnil;
+static unsigned long classes_epoch = 0;
+
+// register the cached VALUEs only once, the registered addresses are static
+static void register_classes()
+{
+  static bool registered = false;
+  if (registered)
+    return;
+
+  rb_gc_register_address(&yast_module);
+  for (int i = 0; i < Y2RUBY_CLASS_COUNT; ++i)
+    rb_gc_register_address(&classes[i].klass);
+
+  registered = true;
+}
+
+VALUE y2ruby_class(y2ruby_class_t kind)
+{
+  y2ruby_class_entry &entry = classes[kind];
+  if (!NIL_P(entry.klass))
+  {
+    if (entry.epoch == classes_epoch)
+      return entry.klass;
+
+    entry.epoch = classes_epoch;
+    if (rb_const_defined_at(yast_module, entry.id)
+      && rb_const_get_at(yast_module, entry.id) == entry.klass)
+      return entry.klass;
+
+    y2milestone("Class Yast::%s was redefined", entry.name);
+    entry.klass = Qnil;
+  }
+
+  register_classes();
+
+  if (!y2_require(entry.feature))
+  {
+    y2internal("Cannot find %s module.", entry.feature);
+    return Qnil;
+  }
+
+  entry.id = rb_intern(entry.name);
+  entry.klass = rb_const_get(y2ruby_yast_module(), entry.id);
+  entry.epoch = classes_epoch;
+  y2debug("Resolved class Yast::%s", entry.name);
+  return entry.klass;
+}
+
+VALUE y2ruby_yast_module()
+{
+  if (NIL_P(yast_module))
+  {
+    register_classes();
+    yast_module = rb_define_module("Yast");
+  }
+
+  return yast_module;
+}
+
+void y2ruby_classes_revalidate()
+{
+  ++classes_epoch;
+}
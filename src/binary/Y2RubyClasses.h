@@ -0,0 +1,60 @@
+/*---------------------------------------------------------------------\
+|                                                                      |
+|                      __   __    ____ _____ ____                      |
+|                      \ \ / /_ _/ ___|_   _|___ \                     |
+|                       \ V / _` \___ \ | |   __) |                    |
+|                        | | (_| |___) || |  / __/                     |
+|                        |_|\__,_|____/ |_| |_____|                    |
+|                                                                      |
+|                                                                      |
+| ruby language support                              (C) Novell Inc.   |
+\----------------------------------------------------------------------/
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version
+2 of the License, or (at your option) any later version.
+
+*/
+
+#ifndef Y2RubyClasses_h
+#define Y2RubyClasses_h
+
+#include <ruby.h>
+
+/**
+ * Yast classes which YCP values are converted to and from
+ */
+enum y2ruby_class_t
+{
+  Y2RUBY_PATH,
+  Y2RUBY_TERM,
+  Y2RUBY_REFERENCE,
+  Y2RUBY_BYTEBLOCK,
+  Y2RUBY_CODE,
+  Y2RUBY_EXTERNAL,
+  Y2RUBY_LAZY_LIST,
+  Y2RUBY_LAZY_MAP,
+  Y2RUBY_CLASS_COUNT
+};
+
+/**
+ * Returns the Ruby class for the given kind, requiring the file defining it
+ * when needed. The class is resolved only once and protected from the GC.
+ * Returns Qnil if the class cannot be loaded.
+ */
+VALUE y2ruby_class(y2ruby_class_t kind);
+
+/**
+ * Returns the Yast module, defining it if it does not exist yet
+ */
+VALUE y2ruby_yast_module();
+
+/**
+ * Makes y2ruby_class check again whether the constant still points to the
+ * resolved class (e.g. after a reload redefined Yast::Term). Only bumps
+ * a counter, each class is looked up on its first use afterwards.
+ */
+void y2ruby_classes_revalidate();
+
+#endif
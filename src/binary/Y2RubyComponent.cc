@@ -26,6 +26,7 @@ as published by the Free Software Foundation; either version
 #include "Y2RubyComponent.h"
 #include "YRuby.h"
 #include "YRubyNamespace.h"
+#include "Y2RubyUtils.h"
 using std::string;
 using std::map;
 
@@ -58,16 +59,11 @@ Y2Namespace *Y2RubyComponent::import (const char* name)
     return cached_namespace->second;
 
   y2debug("Creating namespace for import '%s'", name);
-  // must be the same in Y2CCRuby and Y2RubyComponent
-  string module = YCPPathSearch::find (YCPPathSearch::Module, string (name) + ".rb");
+  string module = findModule (name);
   if (module.empty ())
   {
-    module = YCPPathSearch::find (YCPPathSearch::Module, Y2RubyComponent::CamelCase2DelimSepated(name) + ".rb");
-    if (module.empty ())
-    {
-      y2internal ("Couldn't find %s after Y2CCRuby pointed to us", name);
-      return NULL;
-    }
+    y2internal ("Couldn't find %s after Y2CCRuby pointed to us", name);
+    return NULL;
   }
   y2debug("Found in '%s'", module.c_str());
   module.erase (module.size () - 3 /* strlen (".rb") */);
@@ -76,10 +72,15 @@ Y2Namespace *Y2RubyComponent::import (const char* name)
   args->add (YCPString(/*module*/ module));
 
   try {
-    YRuby::loadModule (args);
-    y2debug("Module '%s' loaded", name);
-    // introspect, create data structures for the interpreter
-    Y2Namespace * res = new YRubyNamespace (name);
+    // the module is required on its first use then
+    Y2Namespace * res = YRubyNamespace::fromManifest (name, module);
+    if (res == NULL)
+    {
+      YRuby::loadModule (args);
+      y2debug("Module '%s' loaded", name);
+      // introspect, create data structures for the interpreter
+      res = new YRubyNamespace (name, module);
+    }
     namespaces[name] = res;
     return res;
   } catch (exception& e) {
@@ -88,33 +89,33 @@ Y2Namespace *Y2RubyComponent::import (const char* name)
   }
 }
 
+string Y2RubyComponent::findModule( const char* name)
+{
+  string module = y2ruby_find_path (YCPPathSearch::Module, string (name) + ".rb");
+  //lets try convert it with rails coding convention
+  if (module.empty ())
+    module = y2ruby_find_path (YCPPathSearch::Module, CamelCase2DelimSepated(name) + ".rb");
+  return module;
+}
+
 const string Y2RubyComponent::CamelCase2DelimSepated( const char* name)
 {
-  string res = name;
-  size_t size = res.size();
-  if (size==0)
-    return res;
-  // convert always in C locale (bnc#852242)
-  char *old_locale = strdup(setlocale(LC_ALL, NULL));
-  setlocale(LC_ALL, "C");
-  res[0] = tolower(res[0]);
-  //first character and first char after :: is lowercase without underscore
-  for(size_t i = res.find("::"); i!= string::npos; i = res.find("::",i+1))
-  {
-    size_t c_pos = i+2; //::<c> so we want c
-    if (c_pos >= size) break; //handle string finishing with ::
-    res[c_pos] = tolower(res[c_pos]);
-  }
-  for (size_t i = 1; i< res.size();i++)
+  // only ASCII letters are converted, independently of the locale (bnc#852242)
+  string res;
+  size_t size = strlen(name);
+  res.reserve(size + size / 2);
+  for (size_t i = 0; i < size; i++)
   {
-    if (isupper(res[i]))
+    char c = name[i];
+    if (c < 'A' || c > 'Z')
     {
-      string tmp = "_";
-      tmp.push_back (tolower(res[i]));
-      res.replace(i,1,tmp); //replace upper by _lower
+      res.push_back(c);
+      continue;
     }
+    //first character and first char after :: is lowercase without underscore
+    if (i > 0 && !(i >= 2 && name[i-1] == ':' && name[i-2] == ':'))
+      res.push_back('_');
+    res.push_back(c - 'A' + 'a');
   }
-  setlocale(LC_ALL, old_locale);
-  free(old_locale);
   return res;
 }
@@ -83,6 +83,13 @@ public:
      * so ActiveSupport namespace is from active_support.rb.
      */
     static const std::string CamelCase2DelimSepated (const char* name);
+
+    /**
+     * Finds the file of the Ruby module, as name.rb or with the delimiter
+     * separated name. The results are remembered.
+     * @return the path, empty if there is no such module
+     */
+    static std::string findModule (const char* name);
 };
 
 #endif	// Y2RubyComponent_h
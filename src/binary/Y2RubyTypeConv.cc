@@ -38,35 +38,84 @@ as published by the Free Software Foundation; either version
 #include <ycp/YCPExternal.h>
 #include <ycp/Import.h>
 #include <ycp/YCode.h>
+#include <ycp/Type.h>
+
+#include <ruby/version.h>
 
 #include <cassert>
+#include <map>
+#include <set>
+#include <vector>
 
 #include "YRuby.h"
 
 #include "Y2RubyTypeConv.h"
 #include "Y2RubyReference.h"
+#include "Y2RubyClasses.h"
 
 #define IS_A(obj,klass) ((rb_obj_is_kind_of((obj),(klass))==Qtrue)?1:0)
 
+// C++ declares the rb_hash_foreach callback as int (*)(...) before ruby 2.7
+#if RUBY_API_VERSION_MAJOR > 2 || (RUBY_API_VERSION_MAJOR == 2 && RUBY_API_VERSION_MINOR >= 7)
+#define HASH_FOREACH_FUNC(func) (func)
+#else
+#define HASH_FOREACH_FUNC(func) ((int (*)(ANYARGS)) (func))
+#endif
+
 /*
- * rbhash_2_ycpmap
- *
- * Internal helper for Hash -> YCPMap
- *
+ * Options and state of one top level conversion
  */
+struct rb_conversion
+{
+  //! keep objects referenced many times shared, see Yast.shared_conversion
+  bool shared;
+  //! already converted objects, YCPNull marks the ones being converted
+  std::map<VALUE, YCPValue> memo;
+  //! keeps the memo keys alive, so their addresses cannot be reused
+  VALUE pinned;
+  //! hash entries with an Array, Hash or Term, converted after the
+  //! others, keys and values alternating; a ruby array, so the GC keeps
+  //! the entries even if the hash changes
+  VALUE entries;
+  //! number of Arrays, Hashes and Terms being converted
+  size_t depth;
+  //! containers being converted, tracked only in deeply nested values
+  std::set<VALUE> path;
+  //! deeply frozen containers converted before, see Yast.cached_conversion
+  VALUE cache;
+  //! the value converted last is deeply frozen, tracked with the cache only
+  bool frozen;
+};
 
-static YCPMap rbhash_2_ycpmap( VALUE value )
+// without the memo, cycles are looked for only below this nesting depth
+#define CYCLE_CHECK_DEPTH 1024
+
+// the cached conversions of frozen values kept alive, the oldest is dropped
+#define FROZEN_CACHE_SIZE 256
+
+// ObjectSpace::WeakMap from frozen containers to their converted values,
+// an entry disappears with its container or with its converted value
+static VALUE frozen_cache = Qnil;
+// the converted values kept alive, the most recent FROZEN_CACHE_SIZE ones
+static VALUE frozen_cache_values = Qnil;
+static long frozen_cache_next = 0;
+static VALUE rb_cFrozenConversion = Qnil;
+
+static YCPValue convert_value( VALUE value, rb_conversion &conversion, int &state );
+
+/*
+ * convert_nested
+ *
+ * Converts a value nested in another one being converted, an error
+ * is raised further to the conversion of the outer value
+ */
+static YCPValue convert_nested( VALUE value, rb_conversion &conversion )
 {
-  YCPMap map;
-  VALUE list = rb_funcall(value, rb_intern("to_a"), 0); //get array of two items array, first is key and second is value
-  for ( unsigned i=0; i<RARRAY_LEN(list); ++i)
-  {
-    VALUE kv_list = *(RARRAY_PTR(list)+i);
-    YCPValue ykey = rbvalue_2_ycpvalue(*RARRAY_PTR(kv_list));
-    YCPValue yvalue = rbvalue_2_ycpvalue(*(RARRAY_PTR(kv_list)+1));
-    map.add(ykey, yvalue);
-  }
-  return map;
+  int state = 0;
+  YCPValue res = convert_value(value, conversion, state);
+  if (state)
+    rb_jump_tag(state);
+  return res;
 }
 
 class YCPRubyProc : public YCode
@@ -101,25 +150,6 @@ static YCPValue rbproc_2_ycpcode( VALUE value )
   return c;
 }
 
-/*
- * rbarray_2_ycplist
- *
- * Internal helper for Array -> YCPList
- *
- */
-
-static YCPList rbarray_2_ycplist( VALUE value )
-{
-  YCPList list;
-  int n = RARRAY_LEN(value);
-  for ( int i=0; i<n; ++i)
-  {
-    list.add(rbvalue_2_ycpvalue(*(RARRAY_PTR(value)+i)));
-  }
-  return list;
-}
-
-
 /*
  * rbreference_2_ycpreference
  *
@@ -137,10 +167,10 @@ static YCPValue rbreference_2_ycpreference( VALUE value )
   return YCPReference(s_entry);
 }
 
-static YCPValue rbargreference_2_ycpreference( VALUE value )
+static YCPValue rbargreference_2_ycpreference( VALUE value, rb_conversion &conversion )
 {
   VALUE val = rb_funcall(value,rb_intern("value"),0);
-  YCPValue v = rbvalue_2_ycpvalue(val);
+  YCPValue v = convert_nested(val, conversion);
   SymbolEntryPtr se = new SymbolEntry(0, 0, "ref", SymbolEntry::c_variable, Type::vt2type(v->valuetype()));
   se->setValue(v);
   return YCPReference(se);
@@ -164,6 +194,31 @@ static YCPValue rbbyteblock_2_ycpbyteblock( VALUE value )
 {
   YCPByteblock *payload;
   Data_Get_Struct(value, YCPByteblock, payload);
+  if (!payload)
+    rb_raise(rb_eRuntimeError, "Byteblock is empty");
+  return *payload;
+}
+
+/*
+ * rblazy_2_ycpvalue
+ *
+ * An untouched lazy proxy is passed back as the YCP value it wraps,
+ * otherwise its items could have been modified and it is converted
+ */
+static YCPValue rblazy_2_ycpvalue( VALUE value, rb_conversion &conversion )
+{
+  static ID id_items = rb_intern("@__items");
+  static ID id_materialized = rb_intern("@__materialized");
+
+  VALUE materialized = rb_attr_get(value, id_materialized);
+  if (!NIL_P(materialized))
+    return convert_nested(materialized, conversion);
+
+  if (!NIL_P(rb_attr_get(value, id_items)))
+    return convert_nested(rb_funcall(value, rb_intern("__getobj__"), 0), conversion);
+
+  YCPValue *payload;
+  Data_Get_Struct(value, YCPValue, payload);
   return *payload;
 }
 
@@ -174,27 +229,92 @@ rbpath_2_ycppath( VALUE value )
   return  YCPPath(StringValuePtr(stringrep));
 }
 
-static YCPValue
-rbterm_2_ycpterm( VALUE value )
+/*
+ * Non primitive Ruby objects known to the component system
+ */
+enum object_kind_t
+{
+  KIND_UNKNOWN,
+  KIND_PATH,
+  KIND_TERM,
+  KIND_ARGREF,
+  KIND_FUNREF,
+  KIND_YREFERENCE,
+  KIND_PROC,
+  KIND_EXTERNAL,
+  KIND_BYTEBLOCK,
+  KIND_LAZY
+};
+
+static const struct
+{
+  const char *name;
+  object_kind_t kind;
+} known_classes[] =
+{
+  { "Yast::Path",       KIND_PATH },
+  { "Yast::Term",       KIND_TERM },
+  { "Yast::ArgRef",     KIND_ARGREF },
+  { "Yast::FunRef",     KIND_FUNREF },
+  { "Yast::YReference", KIND_YREFERENCE },
+  { "Proc",             KIND_PROC },
+  { "Yast::External",   KIND_EXTERNAL },
+  { "Yast::Byteblock",  KIND_BYTEBLOCK },
+  { "Yast::LazyList",   KIND_LAZY },
+  { "Yast::LazyMap",    KIND_LAZY },
+};
+
+/*
+ * class_kind
+ *
+ * Slow path: finds the kind by the class name of klass or of its nearest
+ * known ancestor, so subclasses convert like their parents
+ */
+static object_kind_t class_kind( VALUE klass )
+{
+  for (; !NIL_P(klass); klass = rb_class_superclass(klass))
+  {
+    const char *class_name = rb_class2name(klass);
+    for (size_t i = 0; i < sizeof(known_classes)/sizeof(known_classes[0]); ++i)
+    {
+      if (!strcmp(class_name, known_classes[i].name))
+        return known_classes[i].kind;
+    }
+  }
+  return KIND_UNKNOWN;
+}
+
+/*
+ * object_kind
+ *
+ * The kind is computed once per class and cached in a hidden (not @
+ * prefixed, so invisible from ruby) instance variable of the class,
+ * so the dispatch does not depend on the number of known classes.
+ */
+static object_kind_t object_kind( VALUE value )
 {
-  VALUE id = rb_funcall(value, rb_intern("value"), 0);
-  VALUE params = rb_funcall(value, rb_intern("params"), 0);
-  const char * id_s = rb_id2name(SYM2ID(id));
-  if (params == Qnil)
-    return YCPTerm(id_s);
-  return YCPTerm(id_s,rbarray_2_ycplist(params));
+  static ID id_kind = rb_intern("__y2ruby_kind");
+  VALUE klass = rb_obj_class(value);
+  VALUE cached = rb_attr_get(klass, id_kind);
+  if (FIXNUM_P(cached))
+    return (object_kind_t) FIX2INT(cached);
+
+  object_kind_t kind = class_kind(klass);
+  if (!OBJ_FROZEN(klass))
+    rb_ivar_set(klass, id_kind, INT2FIX(kind));
+  return kind;
 }
 
 
 /*
- * rbvalue_2_ycpvalue
+ * convert_single_value
  *
- * Converts Ruby VALUE to YCP YCPValue
+ * Converts one Ruby VALUE which is not an Array, Hash or Term
  *
  */
 
-YCPValue
-rbvalue_2_ycpvalue( VALUE value )
+static YCPValue
+convert_single_value( VALUE value, rb_conversion &conversion )
 {
   switch (TYPE(value))
   {
@@ -216,12 +336,6 @@ rbvalue_2_ycpvalue( VALUE value )
   case T_FLOAT:
     return YCPFloat(NUM2DBL(value));
     break;
-  case T_ARRAY:
-    return rbarray_2_ycplist(value);
-    break;
-  case T_HASH:
-    return rbhash_2_ycpmap(value);
-    break;
   case T_SYMBOL:
     return YCPSymbol(rb_id2name(rb_to_id(value)));
   //case T_DATA:
@@ -229,47 +343,710 @@ rbvalue_2_ycpvalue( VALUE value )
     break;
   default:
   {
-    const char *class_name = rb_obj_classname(value);
-    if ( !strcmp(class_name, "Yast::Path"))
+    switch (object_kind(value))
     {
+    case KIND_PATH:
       return rbpath_2_ycppath(value);
-    }
-    else if ( !strcmp(class_name, "Yast::Term"))
-    {
-      return rbterm_2_ycpterm(value);
-    }
-    else if ( !strcmp(class_name, "Yast::ArgRef"))
-    {
-      return rbargreference_2_ycpreference(value);
-    }
-    else if ( !strcmp(class_name, "Yast::FunRef"))
-    {
+    case KIND_ARGREF:
+      return rbargreference_2_ycpreference(value, conversion);
+    case KIND_FUNREF:
       return rbreference_2_ycpreference(value);
-    }
-    else if ( !strcmp(class_name, "Yast::YReference"))
-    {
+    case KIND_YREFERENCE:
       return rbyreference_2_ycpreference(value);
+    case KIND_PROC:
+      return rbproc_2_ycpcode(value);
+    case KIND_EXTERNAL:
+      return rbexternal_2_ycpexternal(value);
+    case KIND_BYTEBLOCK:
+      return rbbyteblock_2_ycpbyteblock(value);
+    case KIND_LAZY:
+      return rblazy_2_ycpvalue(value, conversion);
+    default:
+      rb_raise(rb_eRuntimeError, "Invalid value %s passed to component system", RSTRING_PTR(rb_inspect(value)));
     }
-    else if ( !strcmp(class_name, "Proc"))
+  }
+  }
+}
+
+/*
+ * is_container
+ *
+ * Arrays, Hashes and Terms are converted by frames of convert_value
+ */
+
+static bool
+is_container( VALUE value )
+{
+  switch (TYPE(value))
+  {
+  case T_ARRAY:
+  case T_HASH:
+    return true;
+  case T_NIL:
+  case T_TRUE:
+  case T_FALSE:
+  case T_FIXNUM:
+  case T_BIGNUM:
+  case T_FLOAT:
+  case T_STRING:
+  case T_SYMBOL:
+    return false;
+  default:
+    return object_kind(value) == KIND_TERM;
+  }
+}
+
+/*
+ * One Array, Hash or Term being converted by convert_value
+ */
+struct rb_frame
+{
+  enum { ARRAY, HASH, TERM } kind;
+  //! the converted object
+  VALUE object;
+  //! the array, the hash or the params of the term
+  VALUE items;
+  //! next item, for a hash the next entry in rb_conversion::entries
+  long index;
+  //! hash entries left for later are begin...end in rb_conversion::entries,
+  //! array items are expected to be 0...end
+  long begin, end;
+  //! hash size when the entries were collected
+  st_index_t size;
+  YCPList list;
+  YCPMap map;
+  //! converted hash key waiting for its value
+  YCPValue key;
+  //! value of a hash entry converted while iterating the hash
+  YCPValue value;
+  bool have_key;
+  //! symbol of the term
+  ID name;
+  //! object is in rb_conversion::path
+  bool on_path;
+  //! the object and all the items converted so far are frozen
+  bool frozen;
+
+  rb_frame() : object(Qnil), items(Qnil), index(0), begin(0), end(0), size(0),
+    list(YCPNull()), map(YCPNull()), key(YCPNull()), value(YCPNull()), have_key(false), name(0), on_path(false),
+    frozen(false)
+  {}
+};
+
+static void
+frozen_conversion_free( void *p )
+{
+  delete (YCPValue *) p;
+}
+
+/*
+ * frozen_cache_get
+ *
+ * Returns the cached conversion of a deeply frozen container or YCPNull
+ */
+
+static YCPValue
+frozen_cache_get( VALUE cache, VALUE value )
+{
+  static ID id_aref = rb_intern("[]");
+  VALUE converted = rb_funcall(cache, id_aref, 1, value);
+  if (NIL_P(converted))
+    return YCPNull();
+
+  YCPValue *res;
+  Data_Get_Struct(converted, YCPValue, res);
+  return *res;
+}
+
+static void
+frozen_cache_add( VALUE cache, VALUE value, const YCPValue &converted )
+{
+  static ID id_aset = rb_intern("[]=");
+  VALUE wrapped = Data_Wrap_Struct(rb_cFrozenConversion, 0, frozen_conversion_free, new YCPValue(converted));
+  rb_ary_store(frozen_cache_values, frozen_cache_next, wrapped);
+  frozen_cache_next = (frozen_cache_next + 1) % FROZEN_CACHE_SIZE;
+  rb_funcall(cache, id_aset, 2, value, wrapped);
+}
+
+/*
+ * is_frozen_item
+ *
+ * Can the converted value of a scalar item be shared by all conversions
+ * of its frozen container?
+ */
+
+static bool
+is_frozen_item( VALUE value )
+{
+  if (SPECIAL_CONST_P(value))
+    return true;
+
+  switch (TYPE(value))
+  {
+  case T_STRING:
+  case T_FLOAT:
+  case T_BIGNUM:
+    return OBJ_FROZEN(value);
+  default:
+    // references, procs and the like are never shared
+    return OBJ_FROZEN(value) && object_kind(value) == KIND_PATH;
+  }
+}
+
+static bool
+open_value( VALUE value, rb_conversion &conversion, std::vector<rb_frame> &stack, VALUE &pinned, YCPValue &res );
+
+/*
+ * The hash frame being opened, see convert_hash_entry
+ */
+struct rb_hash_iteration
+{
+  rb_conversion *conversion;
+  std::vector<rb_frame> *stack;
+  VALUE *pinned;
+};
+
+/*
+ * convert_hash_entry
+ *
+ * Converts an entry without containers right away, the other entries
+ * are left in rb_conversion::entries for the frames of convert_value
+ */
+static int convert_hash_entry( VALUE key, VALUE value, VALUE data )
+{
+  rb_hash_iteration *iteration = (rb_hash_iteration *) data;
+  rb_conversion &conversion = *iteration->conversion;
+  if (is_container(key) || is_container(value))
+  {
+    rb_ary_push(conversion.entries, key);
+    rb_ary_push(conversion.entries, value);
+    return ST_CONTINUE;
+  }
+
+  // scalars are never opened as frames, so the frame stays in place
+  rb_frame &frame = iteration->stack->back();
+  open_value(key, conversion, *iteration->stack, *iteration->pinned, frame.key);
+  bool frozen = conversion.frozen;
+  open_value(value, conversion, *iteration->stack, *iteration->pinned, frame.value);
+  frame.frozen = frame.frozen && frozen && conversion.frozen;
+  frame.map.add(frame.key, frame.value);
+  frame.key = frame.value = YCPNull();
+  return ST_CONTINUE;
+}
+
+/*
+ * open_value
+ *
+ * Starts the conversion of value. Arrays, hashes and terms get a new frame
+ * on the stack and true is returned, anything else is converted right
+ * away to res. The items being iterated are kept in the pinned array,
+ * frames live outside of the ruby heap and the GC does not see them.
+ * The frame is set up in place on the stack, so it is freed with the
+ * stack when ruby code run meanwhile raises.
+ */
+
+static bool
+open_value( VALUE value, rb_conversion &conversion, std::vector<rb_frame> &stack, VALUE &pinned, YCPValue &res )
+{
+  bool memoized = conversion.shared && !SPECIAL_CONST_P(value);
+  std::map<VALUE, YCPValue>::iterator memo;
+  if (memoized)
+  {
+    std::pair<std::map<VALUE, YCPValue>::iterator, bool> inserted =
+      conversion.memo.insert(std::make_pair(value, YCPValue(YCPNull())));
+    memo = inserted.first;
+    if (!inserted.second)
     {
-      return rbproc_2_ycpcode(value);
+      if (memo->second.isNull())
+        rb_raise(rb_eRuntimeError, "Cyclic %s cannot be passed to component system", rb_obj_classname(value));
+      res = memo->second;
+      conversion.frozen = false;
+      return false;
     }
-    else if ( !strcmp(class_name, "Yast::External"))
+    rb_ary_push(conversion.pinned, value);
+  }
+
+  if (!is_container(value))
+  {
+    res = convert_single_value(value, conversion);
+    if (memoized)
+      memo->second = res;
+    conversion.frozen = !NIL_P(conversion.cache) && is_frozen_item(value);
+    return false;
+  }
+
+  if (!NIL_P(conversion.cache) && OBJ_FROZEN(value))
+  {
+    res = frozen_cache_get(conversion.cache, value);
+    if (!res.isNull())
     {
-      return rbexternal_2_ycpexternal(value);
+      if (memoized)
+        memo->second = res;
+      conversion.frozen = true;
+      return false;
     }
-    else if ( !strcmp(class_name, "Yast::Byteblock"))
+  }
+
+  stack.push_back(rb_frame());
+  rb_frame &frame = stack.back();
+  frame.object = value;
+  frame.frozen = !NIL_P(conversion.cache) && OBJ_FROZEN(value);
+  // the memo finds cycles in the shared mode, otherwise a cycle
+  // makes the nesting endless, so it is caught once the nesting is deep
+  if (!conversion.shared && conversion.depth >= CYCLE_CHECK_DEPTH)
+  {
+    if (!conversion.path.insert(value).second)
+      rb_raise(rb_eRuntimeError, "Cyclic %s cannot be passed to component system", rb_obj_classname(value));
+    frame.on_path = true;
+  }
+
+  switch (TYPE(value))
+  {
+  case T_ARRAY:
+    frame.kind = rb_frame::ARRAY;
+    frame.items = value;
+    break;
+  case T_HASH:
+  {
+    frame.kind = rb_frame::HASH;
+    frame.items = value;
+    frame.map = YCPMap();
+    frame.size = RHASH_SIZE(value);
+    // iterate the hash directly, no intermediate arrays of pairs;
+    // the entries left for later of all the hashes share one array
+    if (NIL_P(conversion.entries))
+      conversion.entries = rb_ary_new();
+    frame.begin = frame.index = RARRAY_LEN(conversion.entries);
+    rb_hash_iteration iteration = { &conversion, &stack, &pinned };
+    rb_hash_foreach(value, HASH_FOREACH_FUNC(convert_hash_entry), (VALUE) &iteration);
+    frame.end = RARRAY_LEN(conversion.entries);
+    break;
+  }
+  default:
+  {
+    frame.kind = rb_frame::TERM;
+    VALUE id = rb_funcall(value, rb_intern("value"), 0);
+    frame.name = SYM2ID(id);
+    frame.items = rb_funcall(value, rb_intern("params"), 0);
+    break;
+  }
+  }
+
+  // a frozen term can still get new params
+  if (frame.kind == rb_frame::TERM && !(RB_TYPE_P(frame.items, T_ARRAY) && OBJ_FROZEN(frame.items)))
+    frame.frozen = false;
+
+  if (frame.kind != rb_frame::HASH)
+  {
+    frame.list = YCPList();
+    if (!NIL_P(frame.items))
     {
-      return rbbyteblock_2_ycpbyteblock(value);
+      frame.end = RARRAY_LEN(frame.items);
+      // size the list up front, it is filled by appending only
+      frame.list.reserve(frame.end);
     }
-    else
+  }
+
+  if (NIL_P(pinned))
+    pinned = rb_ary_new();
+  rb_ary_push(pinned, frame.items);
+  ++conversion.depth;
+  return true;
+}
+
+/*
+ * next_item
+ *
+ * Returns the next item of the frame to convert, false when all are done.
+ * Hashes return the key and then its value.
+ */
+
+static bool
+next_item( const rb_frame &frame, const rb_conversion &conversion, VALUE &item )
+{
+  if (frame.kind == rb_frame::HASH)
+  {
+    // converting an entry can run ruby code (e.g. Term#params)
+    if (RHASH_SIZE(frame.items) != frame.size)
+      rb_raise(rb_eRuntimeError, "Hash modified during conversion to YCP map");
+    if (frame.index >= frame.end)
+      return false;
+
+    item = RARRAY_AREF(conversion.entries, frame.index);
+    return true;
+  }
+
+  if (frame.index >= frame.end)
+    return false;
+
+  // the array can be modified by ruby code run by the conversion
+  if (frame.index >= RARRAY_LEN(frame.items))
+    rb_raise(rb_eRuntimeError, "Array modified during conversion to YCP list");
+
+  item = RARRAY_AREF(frame.items, frame.index);
+  return true;
+}
+
+/*
+ * add_item
+ *
+ * Stores the converted item returned by next_item to the frame result
+ */
+
+static void
+add_item( rb_frame &frame, const rb_conversion &conversion, const YCPValue &item )
+{
+  ++frame.index;
+  frame.frozen = frame.frozen && conversion.frozen;
+  if (frame.kind != rb_frame::HASH)
+  {
+    frame.list.add(item);
+  }
+  else if (!frame.have_key)
+  {
+    frame.key = item;
+    frame.have_key = true;
+  }
+  else
+  {
+    frame.map.add(frame.key, item);
+    frame.key = YCPNull();
+    frame.have_key = false;
+  }
+}
+
+/*
+ * close_frame
+ *
+ * Returns the converted value of the completed frame
+ */
+
+static YCPValue
+close_frame( const rb_frame &frame, rb_conversion &conversion )
+{
+  YCPValue res = YCPNull();
+  switch (frame.kind)
+  {
+  case rb_frame::ARRAY:
+    res = frame.list;
+    break;
+  case rb_frame::HASH:
+    res = frame.map;
+    rb_ary_resize(conversion.entries, frame.begin);
+    break;
+  case rb_frame::TERM:
+    res = YCPTerm(rb_id2name(frame.name), frame.list);
+    break;
+  }
+
+  if (conversion.shared)
+    conversion.memo[frame.object] = res;
+  // all the items are frozen, so the converted value can be shared
+  if (frame.frozen)
+    frozen_cache_add(conversion.cache, frame.object, res);
+  conversion.frozen = frame.frozen;
+  if (frame.on_path)
+    conversion.path.erase(frame.object);
+  --conversion.depth;
+  return res;
+}
+
+/*
+ * State of convert_value passed through rb_protect
+ */
+struct rb_convert_loop
+{
+  VALUE value;
+  rb_conversion *conversion;
+  std::vector<rb_frame> *stack;
+  VALUE *pinned;
+  YCPValue *res;
+};
+
+static VALUE
+convert_loop( VALUE data )
+{
+  rb_convert_loop *loop = (rb_convert_loop *) data;
+  rb_conversion &conversion = *loop->conversion;
+  std::vector<rb_frame> &stack = *loop->stack;
+  YCPValue &res = *loop->res;
+
+  if (!open_value(loop->value, conversion, stack, *loop->pinned, res))
+    return Qnil;
+
+  while (true)
+  {
+    VALUE item;
+    if (next_item(stack.back(), conversion, item))
     {
-      rb_raise(rb_eRuntimeError, "Invalid value %s passed to component system", RSTRING_PTR(rb_inspect(value)));
+      // a new frame is converted first, its result is added when closed
+      if (!open_value(item, conversion, stack, *loop->pinned, res))
+        add_item(stack.back(), conversion, res);
+      continue;
     }
+
+    res = close_frame(stack.back(), conversion);
+    stack.pop_back();
+    rb_ary_pop(*loop->pinned);
+    if (stack.empty())
+      break;
+
+    add_item(stack.back(), conversion, res);
   }
+  return Qnil;
+}
+
+/*
+ * convert_value
+ *
+ * Converting part of rbvalue_2_ycpvalue. Nested values are walked with
+ * an explicit stack, so the nesting depth is not limited by the C stack.
+ * In the shared mode every object is converted only once and cycles are
+ * reported instead of nesting endlessly.
+ *
+ * The walk runs under rb_protect: a raised error would jump over the
+ * stack of frames and the values being built. It is freed first and
+ * the error is returned in state, the caller raises it again.
+ */
+
+static YCPValue
+convert_value( VALUE value, rb_conversion &conversion, int &state )
+{
+  YCPValue res = YCPNull();
+  {
+    std::vector<rb_frame> stack;
+    VALUE pinned = Qnil;
+    rb_convert_loop loop = { value, &conversion, &stack, &pinned, &res };
+    rb_protect(convert_loop, (VALUE) &loop, &state);
+    RB_GC_GUARD(pinned);
   }
+  if (state)
+    return YCPNull();
+  return res;
+}
+
+static void
+init_frozen_cache()
+{
+  if (!NIL_P(frozen_cache))
+    return;
+
+  frozen_cache = rb_class_new_instance(0, NULL, rb_path2class("ObjectSpace::WeakMap"));
+  rb_gc_register_address(&frozen_cache);
+  frozen_cache_values = rb_ary_new2(FROZEN_CACHE_SIZE);
+  rb_gc_register_address(&frozen_cache_values);
+  rb_cFrozenConversion = rb_define_class_under(y2ruby_yast_module(), "FrozenConversion", rb_cObject);
+  rb_undef_alloc_func(rb_cFrozenConversion);
+  // an implementation detail of the cache, not an API
+  rb_funcall(y2ruby_yast_module(), rb_intern("private_constant"), 1, ID2SYM(rb_intern("FrozenConversion")));
+  rb_gc_register_address(&rb_cFrozenConversion);
 }
 
+/*
+ * rbvalue_2_ycpvalue
+ *
+ * Converts Ruby VALUE to YCP YCPValue
+ *
+ */
 
+YCPValue
+rbvalue_2_ycpvalue( VALUE value )
+{
+  static ID id_shared = rb_intern("@__shared_conversion");
+  static ID id_cached = rb_intern("@__cached_conversion");
 
+  // set by Yast.shared_conversion and Yast.cached_conversion
+  bool shared = RTEST(rb_attr_get(y2ruby_yast_module(), id_shared));
+  bool cached = RTEST(rb_attr_get(y2ruby_yast_module(), id_cached));
+  if (cached)
+    init_frozen_cache();
 
+  int state = 0;
+  YCPValue res = YCPNull();
+  // the conversion is freed before an error is raised again
+  {
+    rb_conversion conversion;
+    conversion.shared = shared;
+    conversion.pinned = shared ? rb_ary_new() : Qnil;
+    conversion.depth = 0;
+    conversion.frozen = false;
+    conversion.cache = cached ? frozen_cache : Qnil;
+    conversion.entries = Qnil;
+    res = convert_value(value, conversion, state);
+    RB_GC_GUARD(conversion.pinned);
+    RB_GC_GUARD(conversion.entries);
+  }
+  if (state)
+    rb_jump_tag(state);
+  return res;
+}
+
+/*
+ * Scalar YCP types converted directly when declared
+ */
+enum scalar_type_t
+{
+  SCALAR_NONE,
+  SCALAR_BOOLEAN,
+  SCALAR_INTEGER,
+  SCALAR_FLOAT,
+  SCALAR_STRING,
+  SCALAR_SYMBOL
+};
+
+static scalar_type_t
+scalar_type( constTypePtr type )
+{
+  if (!type || type->isReference())
+    return SCALAR_NONE;
+  if (type->isBoolean())
+    return SCALAR_BOOLEAN;
+  if (type->isInteger())
+    return SCALAR_INTEGER;
+  if (type->isFloat())
+    return SCALAR_FLOAT;
+  if (type->isString())
+    return SCALAR_STRING;
+  if (type->isSymbol())
+    return SCALAR_SYMBOL;
+  return SCALAR_NONE;
+}
+
+/*
+ * typed_scalar
+ *
+ * Converts a value of the declared scalar type without probing its class.
+ * nil is valid for any type. Returns YCPNull if the value has another type.
+ */
+static YCPValue
+typed_scalar( VALUE value, scalar_type_t type )
+{
+  if (NIL_P(value))
+    return YCPVoid();
+
+  switch (type)
+  {
+  case SCALAR_BOOLEAN:
+    if (value == Qtrue || value == Qfalse)
+      return YCPBoolean(value == Qtrue);
+    break;
+  case SCALAR_INTEGER:
+    // a bignum may not fit, the generic conversion reports it
+    if (FIXNUM_P(value))
+      return YCPInteger(FIX2LONG(value));
+    break;
+  case SCALAR_FLOAT:
+    if (RB_FLOAT_TYPE_P(value))
+      return YCPFloat(NUM2DBL(value));
+    break;
+  case SCALAR_STRING:
+    if (RB_TYPE_P(value, T_STRING))
+      return YCPString(StringValuePtr(value));
+    break;
+  case SCALAR_SYMBOL:
+    if (SYMBOL_P(value))
+      return YCPSymbol(rb_id2name(SYM2ID(value)));
+    break;
+  case SCALAR_NONE:
+    break;
+  }
+  return YCPNull();
+}
+
+static YCPValue
+typed_list( VALUE value, scalar_type_t item_type )
+{
+  long size = RARRAY_LEN(value);
+  YCPList list;
+  list.reserve(size);
+  for (long i = 0; i < size; ++i)
+  {
+    YCPValue item = typed_scalar(rb_ary_entry(value, i), item_type);
+    if (item.isNull())
+      return YCPNull();
+    list.add(item);
+  }
+  return list;
+}
+
+struct typed_map_data
+{
+  scalar_type_t key_type;
+  scalar_type_t value_type;
+  YCPMap map;
+  bool matches;
+};
+
+static int
+typed_map_entry( VALUE key, VALUE value, VALUE data )
+{
+  typed_map_data *map_data = (typed_map_data *) data;
+  YCPValue ycp_key = typed_scalar(key, map_data->key_type);
+  YCPValue ycp_value = typed_scalar(value, map_data->value_type);
+  if (ycp_key.isNull() || ycp_value.isNull())
+  {
+    map_data->matches = false;
+    return ST_STOP;
+  }
+  map_data->map.add(ycp_key, ycp_value);
+  return ST_CONTINUE;
+}
+
+static YCPValue
+typed_map( VALUE value, scalar_type_t key_type, scalar_type_t value_type )
+{
+  typed_map_data data;
+  data.key_type = key_type;
+  data.value_type = value_type;
+  data.matches = true;
+  rb_hash_foreach(value, HASH_FOREACH_FUNC(typed_map_entry), (VALUE) &data);
+  if (!data.matches)
+    return YCPNull();
+  return data.map;
+}
+
+/*
+ * rbvalue_2_ycpvalue_typed
+ *
+ * Converts Ruby VALUE to YCP YCPValue of the declared type
+ *
+ */
+
+YCPValue
+rbvalue_2_ycpvalue_typed( VALUE value, constTypePtr type, bool &matches )
+{
+  matches = true;
+  // a reference is passed as Yast::ArgRef, not as the referenced value
+  if (!type || type->isReference())
+    return rbvalue_2_ycpvalue(value);
+
+  YCPValue res = YCPNull();
+  scalar_type_t scalar = scalar_type(type);
+  if (scalar != SCALAR_NONE)
+    res = typed_scalar(value, scalar);
+  else if (type->isList() && RB_TYPE_P(value, T_ARRAY))
+  {
+    scalar_type_t item_type = scalar_type(((constListTypePtr)type)->type());
+    if (item_type == SCALAR_NONE)
+      return rbvalue_2_ycpvalue(value);
+    res = typed_list(value, item_type);
+  }
+  else if (type->isMap() && RB_TYPE_P(value, T_HASH))
+  {
+    constMapTypePtr map_type = (constMapTypePtr)type;
+    scalar_type_t key_type = scalar_type(map_type->keytype());
+    scalar_type_t value_type = scalar_type(map_type->valuetype());
+    if (key_type == SCALAR_NONE || value_type == SCALAR_NONE)
+      return rbvalue_2_ycpvalue(value);
+    res = typed_map(value, key_type, value_type);
+  }
+  else
+    // containers of containers, any, terms... are checked by YCP itself
+    return rbvalue_2_ycpvalue(value);
+
+  if (!res.isNull())
+    return res;
+
+  matches = false;
+  return rbvalue_2_ycpvalue(value);
+}
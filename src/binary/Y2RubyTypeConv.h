@@ -23,14 +23,26 @@ as published by the Free Software Foundation; either version
 #define Y2RUBYTYPECONV_H
 
 #include <ycp/YCPValue.h>
+#include <ycp/Type.h>
 #include <ruby.h>
 
 /**
  * Converts a Ruby Value into a YCPValue
- * Supports neested lists and maps using recursion.
+ * Supports nested lists and maps of any depth.
  */
 YCPValue
 rbvalue_2_ycpvalue( VALUE value );
 
+/**
+ * Converts a Ruby Value into a YCPValue of the declared type. Lists and
+ * maps of declared scalar types are converted directly, without probing
+ * each item. A value not matching the type is converted like in
+ * rbvalue_2_ycpvalue so the caller can report the mismatch once.
+ * @param type declared type, may be NULL
+ * @param matches set to false if the value does not match the type
+ */
+YCPValue
+rbvalue_2_ycpvalue_typed( VALUE value, constTypePtr type, bool &matches );
+
 #endif
 
@@ -1,11 +1,14 @@
+#include <map>
 #include <vector>
 #include <string>
 
 #include <ruby.h>
 #include <ruby/encoding.h>
+#include <ruby/debug.h>
 
 #define y2log_component "Y2Ruby"
 #include <ycp/y2log.h>
+#include <ycp/pathsearch.h>
 
 #include "y2util/stringutil.h"
 #include "Y2RubyUtils.h"
@@ -73,3 +76,70 @@ VALUE yrb_utf8_str_new(const char *str) {
   return rb_enc_str_new(str, strlen(str), utf8);
 }
 
+// enough for the C functions between the ruby levels looked at
+#define CALLER_MAX_FRAMES 16
+
+bool y2ruby_caller_location(int skip, std::string &file, int &line)
+{
+  VALUE frames[CALLER_MAX_FRAMES];
+  int lines[CALLER_MAX_FRAMES];
+  int count = rb_profile_frames(0, CALLER_MAX_FRAMES, frames, lines);
+
+  for (int i = 0; i < count; ++i)
+  {
+    // C functions have no line (newer rubies list them too)
+    if (lines[i] == 0 || skip-- > 0)
+      continue;
+
+    VALUE path = rb_profile_frame_path(frames[i]);
+    if (NIL_P(path))
+      return false;
+
+    file.assign(RSTRING_PTR(path), RSTRING_LEN(path));
+    line = lines[i];
+    return true;
+  }
+  return false;
+}
+
+// yastx and the plugin have their own copies of the remembered paths,
+// a counter in the Yast module tells both when the search paths change
+static ID search_paths_generation_id()
+{
+  static ID id = rb_intern("@__search_paths_generation");
+  return id;
+}
+
+static long search_paths_generation()
+{
+  VALUE generation = rb_attr_get(rb_define_module("Yast"), search_paths_generation_id());
+  return NIL_P(generation) ? 0 : NUM2LONG(generation);
+}
+
+void y2ruby_search_paths_changed()
+{
+  rb_ivar_set(rb_define_module("Yast"), search_paths_generation_id(), LONG2NUM(search_paths_generation() + 1));
+}
+
+string y2ruby_find_path(int kind, const string &name)
+{
+  typedef map<pair<int, string>, string> found_paths_t;
+  static found_paths_t found;
+  static long generation = 0;
+
+  long current = search_paths_generation();
+  if (current != generation)
+  {
+    found.clear();
+    generation = current;
+  }
+
+  pair<int, string> key(kind, name);
+  found_paths_t::iterator it = found.find(key);
+  if (it != found.end())
+    return it->second;
+
+  string path = YCPPathSearch::find((YCPPathSearch::Kind) kind, name);
+  found.insert(make_pair(key, path));
+  return path;
+}
@@ -43,4 +43,26 @@ bool y2_require(const char *str);
 VALUE yrb_utf8_str_new(const std::string &str);
 VALUE yrb_utf8_str_new(const char *str);
 
+/**
+ * Finds the file and line of the ruby code skip levels above the nearest
+ * ruby method (0 is the ruby method calling the current C function).
+ * Only the top frames are inspected, so the cost does not depend on
+ * the depth of the stack. Returns false if there is no such frame.
+ */
+bool y2ruby_caller_location(int skip, std::string &file, int &line);
+
+/**
+ * YCPPathSearch::find with the results, including the missing files,
+ * remembered. The first lookup of a name probes the file system, the next
+ * ones are map lookups until the search paths change.
+ * @param kind YCPPathSearch::Kind
+ */
+std::string y2ruby_find_path(int kind, const std::string &name);
+
+/**
+ * Forgets the paths remembered by y2ruby_find_path in all the libraries,
+ * to be called when a search path is added
+ */
+void y2ruby_search_paths_changed();
+
 #endif
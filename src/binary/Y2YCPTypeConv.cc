@@ -39,60 +39,87 @@ as published by the Free Software Foundation; either version
 #include <ycp/Import.h>
 
 #include <cassert>
+#include <map>
+#include <vector>
 
 #include "YRuby.h"
 
 #include "Y2YCPTypeConv.h"
 #include "Y2RubyUtils.h"
+#include "Y2RubyClasses.h"
 
 //must match same magic id as in vica versa conversion
 #define YCP_EXTERNAL_MAGIC "Ruby object"
 
-extern "C" VALUE
-ycp_path_to_rb_path( YCPPath ycppath )
+/*
+ * Options of one top level conversion
+ */
+struct ycp_conversion
 {
-  if (!y2_require("yast/path"))
-  {
-    y2internal("Cannot find yast/path module.");
-    return Qnil;
-  }
+  //! big lists and maps are converted to lazy proxies
+  bool lazy;
+  //! values referenced many times stay shared, see Yast.shared_conversion
+  bool shared;
+  //! the converted list or map itself is not a proxy, only its items
+  bool eager_root;
+  //! map keys are interned frozen strings, see Yast.interned_conversion
+  bool intern_keys;
+  //! short string values are interned too
+  bool intern_values;
+  //! already converted values in the shared mode
+  std::map<const YCPValueRep *, VALUE> memo;
+  //! keeps the memo values alive for the whole conversion; a hash stores
+  //! a frozen copy of a string key, so the memoized key itself is not
+  //! referenced from the result
+  VALUE memo_values;
 
-  VALUE yast = rb_define_module("Yast");
-  VALUE cls = rb_const_get(yast, rb_intern("Path"));
-  VALUE value = yrb_utf8_str_new(ycppath->toString());
-  return rb_class_new_instance(1,&value,cls);
+  ycp_conversion() : memo_values(Qnil)
+  {}
+};
+
+/*
+ * memoize
+ *
+ * Remembers the converted value of rep in the shared mode
+ */
+
+static void
+memoize( ycp_conversion &conversion, const YCPValueRep *rep, VALUE value )
+{
+  if (NIL_P(conversion.memo_values))
+    conversion.memo_values = rb_ary_new();
+  rb_ary_push(conversion.memo_values, value);
+  conversion.memo[rep] = value;
 }
 
+// lists and maps smaller than this are converted eagerly even in lazy mode
+#define LAZY_CONVERSION_MIN_SIZE 64
+
+// longer strings are not interned, they rarely repeat
+#define INTERN_MAX_LENGTH 64
+// the intern cache is dropped when it grows over this
+#define INTERN_CACHE_MAX_SIZE 4096
+
+static VALUE convert_value( YCPValue ycpval, ycp_conversion &conversion );
+
 extern "C" VALUE
-ycp_term_to_rb_term( YCPTerm ycpterm )
+ycp_path_to_rb_path( YCPPath ycppath )
 {
-  if (!y2_require("yast/term"))
-  {
-    y2internal("Cannot find yast/term module.");
+  VALUE cls = y2ruby_class(Y2RUBY_PATH);
+  if (NIL_P(cls))
     return Qnil;
-  }
 
-  VALUE yast = rb_define_module("Yast");
-  VALUE cls = rb_const_get(yast, rb_intern("Term"));
-  VALUE params = ycpvalue_2_rbvalue(ycpterm->args());
-  if (params == Qnil)
-    params = rb_ary_new2(1);
-//we need to pass array of parameters to work properly with unlimited params in ruby
-  rb_ary_unshift(params, ID2SYM(rb_intern(ycpterm->name().c_str())));
-  return rb_class_new_instance(RARRAY_LEN(params), RARRAY_PTR(params),cls);
+  VALUE value = yrb_utf8_str_new(ycppath->toString());
+  return rb_class_new_instance(1,&value,cls);
 }
 
 extern "C" VALUE
 ycp_ref_to_rb_ref( YCPReference ycpref )
 {
-  if (!y2_require("yastx"))
-  {
-    y2internal("Cannot find yastx module.");
+  VALUE cls = y2ruby_class(Y2RUBY_REFERENCE);
+  if (NIL_P(cls))
     return Qnil;
-  }
 
-  VALUE yast = rb_define_module("Yast");
-  VALUE cls = rb_const_get(yast, rb_intern("YReference"));
   return Data_Wrap_Struct(cls, 0, NULL, (void*)&*ycpref->entry());
 }
 
@@ -106,15 +133,12 @@ rb_bb_free(void *p)
 extern "C" VALUE
 ycp_bb_to_rb_bb( YCPByteblock ycpbb )
 {
-  if (!y2_require("yastx"))
-  {
-    y2internal("Cannot find yastx module.");
+  VALUE cls = y2ruby_class(Y2RUBY_BYTEBLOCK);
+  if (NIL_P(cls))
     return Qnil;
-  }
 
-  VALUE yast = rb_define_module("Yast");
-  VALUE cls = rb_const_get(yast, rb_intern("Byteblock"));
-  return Data_Wrap_Struct(cls, 0, rb_bb_free, new YCPByteblock(ycpbb->value(), ycpbb->size()));
+  // share the refcounted byteblock, the bytes are not copied
+  return Data_Wrap_Struct(cls, 0, rb_bb_free, new YCPByteblock(ycpbb));
 }
 
 extern "C" void
@@ -127,14 +151,10 @@ rb_yc_free(void *p)
 extern "C" VALUE
 ycp_code_to_rb_code( YCPCode ycode )
 {
-  if (!y2_require("yastx"))
-  {
-    y2internal("Cannot find yastx module.");
+  VALUE cls = y2ruby_class(Y2RUBY_CODE);
+  if (NIL_P(cls))
     return Qnil;
-  }
 
-  VALUE yast = rb_define_module("Yast");
-  VALUE cls = rb_const_get(yast, rb_intern("YCode"));
   YCPCode * yc = new YCPCode(ycode);
   VALUE res = Data_Wrap_Struct(cls, 0, rb_yc_free, yc);
   rb_obj_call_init(res,0, NULL);
@@ -152,110 +172,513 @@ extern "C" VALUE
 ycp_ext_to_rb_ext( YCPExternal ext )
 {
   y2debug("Convert ext %s", ext->toString().c_str());
-  if (!y2_require("yast"))
-  {
-    y2internal("Cannot find yast module.");
+  VALUE cls = y2ruby_class(Y2RUBY_EXTERNAL);
+  if (NIL_P(cls))
     return Qnil;
-  }
 
-  VALUE yast = rb_define_module("Yast");
-  VALUE cls = rb_const_get(yast, rb_intern("External"));
   VALUE tdata = Data_Wrap_Struct(cls, 0, rb_ext_free, new YCPExternal(ext));
   VALUE argv[] = {yrb_utf8_str_new(ext->magic())};
   rb_obj_call_init(tdata, 1, argv);
   return tdata;
 }
 
-/**
+extern "C" void
+rb_lazy_free(void *p)
+{
+  YCPValue *value = (YCPValue*) p;
+  delete value;
+}
+
+/*
+ * ycp_lazy_proxy
  *
- * ycpvalue_2_rbvalue
+ * Wraps a list or map to a proxy converting its items on access.
+ * The proxy holds a reference to the YCP value, so nothing is copied.
+ * Returns Qundef if the proxy class is not available.
+ */
+static VALUE
+ycp_lazy_proxy( YCPValue ycpval, y2ruby_class_t kind )
+{
+  VALUE cls = y2ruby_class(kind);
+  if (NIL_P(cls))
+    return Qundef;
+
+  return Data_Wrap_Struct(cls, 0, rb_lazy_free, new YCPValue(ycpval));
+}
+
+/*
+ * convert_single_value
  *
- * Converts a YCPValue into a Ruby Value
- * Supports neested lists using recursion.
+ * Converts one YCPValue of the given type which is not a list, map
+ * or term. A single switch, the common scalars match without any
+ * further virtual calls.
  */
 
-extern "C" VALUE
-ycpvalue_2_rbvalue( YCPValue ycpval )
+static VALUE
+convert_single_value( const YCPValue &ycpval, YCPValueType type )
 {
-  if (ycpval.isNull() || ycpval->isVoid())
+  switch (type)
   {
+  case YT_VOID:
     return Qnil;
+  case YT_BOOLEAN:
+    return ycpval->asBoolean()->value() ? Qtrue : Qfalse;
+  case YT_INTEGER:
+    return LL2NUM( ycpval->asInteger()->value() );
+  case YT_FLOAT:
+    return rb_float_new(ycpval->asFloat()->value());
+  case YT_STRING:
+    // always use UTF-8 encoding
+    return yrb_utf8_str_new(ycpval->asString()->value());
+  case YT_SYMBOL:
+    return ID2SYM(rb_intern(ycpval->asSymbol()->symbol_cstr()));
+  case YT_PATH:
+    return ycp_path_to_rb_path(ycpval->asPath());
+  case YT_REFERENCE:
+    return ycp_ref_to_rb_ref(ycpval->asReference());
+  case YT_EXTERNAL:
+    return ycp_ext_to_rb_ext(ycpval->asExternal());
+  case YT_CODE:
+    return ycp_code_to_rb_code(ycpval->asCode());
+  case YT_BYTEBLOCK:
+    return ycp_bb_to_rb_bb(ycpval->asByteblock());
+  default:
+    break;
   }
-  else if (ycpval->isBoolean())
+  rb_raise( rb_eTypeError, "Conversion of YCP type '%s': %s not supported", Type::vt2type(type)->toString().c_str(), ycpval->toString().c_str() );
+  return Qnil;
+}
+
+/*
+ * scalar_list_to_rb_array
+ *
+ * Fast path for lists of items of one scalar type (e.g. list<string>),
+ * the array is filled without dispatching on every item.
+ * Returns Qundef for any other list.
+ */
+
+static VALUE
+scalar_list_to_rb_array( const YCPList &list )
+{
+  int size = list.size();
+  if (size == 0)
+    return rb_ary_new();
+
+  YCPValueType type = list.value(0)->valuetype();
+  switch (type)
   {
-    return ycpval->asBoolean()->value() ? Qtrue : Qfalse;
+  case YT_BOOLEAN:
+  case YT_INTEGER:
+  case YT_FLOAT:
+  case YT_STRING:
+  case YT_SYMBOL:
+    break;
+  default:
+    return Qundef;
   }
-  else if (ycpval->isString())
+
+  for (int i = 1; i < size; ++i)
   {
-    // always use UTF-8 encoding
-    return yrb_utf8_str_new(ycpval->asString()->value());
+    if (list.value(i)->valuetype() != type)
+      return Qundef;
   }
-  else if (ycpval->isPath())
+
+  VALUE res = rb_ary_new2(size);
+  switch (type)
   {
-    return ycp_path_to_rb_path(ycpval->asPath());
+  case YT_INTEGER:
+    for (int i = 0; i < size; ++i)
+      rb_ary_push(res, LL2NUM(list.value(i)->asInteger()->value()));
+    break;
+  case YT_STRING:
+    for (int i = 0; i < size; ++i)
+      rb_ary_push(res, yrb_utf8_str_new(list.value(i)->asString()->value()));
+    break;
+  default:
+    for (int i = 0; i < size; ++i)
+      rb_ary_push(res, convert_single_value(list.value(i), type));
+    break;
   }
-  else if (ycpval->isTerm())
+  return res;
+}
+
+/*
+ * interned_string
+ *
+ * Returns a frozen UTF-8 string shared by all conversions in the interning
+ * mode, so repeated map keys are allocated only once. The cache is bounded,
+ * when full it is dropped; the strings already returned stay valid.
+ */
+
+static VALUE
+interned_string( const std::string &str )
+{
+  static std::map<std::string, VALUE> cache;
+  // keeps the cached strings alive
+  static VALUE cached = Qnil;
+
+  if (str.size() > INTERN_MAX_LENGTH)
+    return rb_obj_freeze(yrb_utf8_str_new(str));
+
+  std::map<std::string, VALUE>::iterator it = cache.find(str);
+  if (it != cache.end())
+    return it->second;
+
+  if (NIL_P(cached))
   {
-    return ycp_term_to_rb_term(ycpval->asTerm());
+    cached = rb_ary_new();
+    rb_gc_register_address(&cached);
   }
-  else if (ycpval->isInteger())
+  else if (cache.size() >= INTERN_CACHE_MAX_SIZE)
   {
-    return LL2NUM( ycpval->asInteger()->value() );
+    cache.clear();
+    rb_ary_clear(cached);
   }
-  else if (ycpval->isFloat())
+
+  VALUE res = rb_obj_freeze(yrb_utf8_str_new(str));
+  rb_ary_push(cached, res);
+  cache.insert(std::make_pair(str, res));
+  return res;
+}
+
+/*
+ * One list, map or term being converted by convert_value
+ */
+struct ycp_frame
+{
+  enum { LIST, MAP, TERM } kind;
+  //! the converted value, keeps the iterated items alive
+  YCPValue value;
+  //! items of a list or arguments of a term
+  YCPList items;
+  int index;
+  YCPMap::const_iterator it, end;
+  //! Array or Hash being filled, for a term the array of its parameters
+  VALUE result;
+  //! converted map key waiting for its value
+  VALUE key;
+  bool have_key;
+
+  ycp_frame() : value(YCPNull()), index(0), result(Qnil), key(Qnil), have_key(false)
+  {}
+};
+
+/*
+ * open_value
+ *
+ * Starts the conversion of ycpval, key is true for map keys. Lists, maps and terms get a new frame
+ * on the stack and true is returned, anything else is converted right
+ * away to res. Partial results are kept in the pinned array, frames live
+ * outside of the ruby heap and the GC does not see them.
+ */
+
+static bool
+open_value( YCPValue ycpval, bool key, ycp_conversion &conversion, std::vector<ycp_frame> &stack, VALUE &pinned, VALUE &res )
+{
+  if (ycpval.isNull())
   {
-    return rb_float_new(ycpval->asFloat()->value());
+    res = Qnil;
+    return false;
+  }
+
+  YCPValueType type = ycpval->valuetype();
+  if (type == YT_STRING && (key ? conversion.intern_keys : conversion.intern_values))
+  {
+    res = interned_string(ycpval->asString()->value());
+    return false;
   }
-  else if ( ycpval->isMap() )
+
+  const YCPValueRep *rep = ycpval.operator->();
+  switch (type)
   {
-    VALUE rbhash;
-    rbhash = rb_hash_new();
-    YCPMap map = ycpval->asMap();
-    //y2internal("map size %d\n", (int) map.size());
+  case YT_STRING:
+  case YT_LIST:
+  case YT_MAP:
+  case YT_TERM:
+    if (conversion.shared)
+    {
+      std::map<const YCPValueRep *, VALUE>::iterator it = conversion.memo.find(rep);
+      if (it != conversion.memo.end())
+      {
+        res = it->second;
+        return false;
+      }
+    }
+    break;
+  default:
+    res = convert_single_value(ycpval, type);
+    return false;
+  }
+
+  ycp_frame frame;
+  frame.value = ycpval;
+  // the root of a shallow conversion is never a proxy
+  bool proxy = conversion.lazy && !(conversion.eager_root && stack.empty());
+  // stays Qundef when a frame is needed
+  res = Qundef;
 
-    for (YCPMap::const_iterator it = map->begin(); it != map->end(); ++it)
+  switch (type)
+  {
+  case YT_LIST:
+  {
+    frame.kind = ycp_frame::LIST;
+    frame.items = ycpval->asList();
+    if (proxy && frame.items.size() >= LAZY_CONVERSION_MIN_SIZE)
+    {
+      res = ycp_lazy_proxy(ycpval, Y2RUBY_LAZY_LIST);
+      if (res != Qundef)
+        break;
+    }
+    // the shared and interning modes handle strings themselves
+    if (!conversion.shared && !conversion.intern_values)
     {
-      YCPValue key = it->first;
-      YCPValue value = it->second;
-      rb_hash_aset(rbhash, ycpvalue_2_rbvalue(key), ycpvalue_2_rbvalue(value) );
+      res = scalar_list_to_rb_array(frame.items);
+      if (res != Qundef)
+        break;
     }
-    return rbhash;
+    frame.result = rb_ary_new2(frame.items.size());
+    break;
   }
-  else if (ycpval->isList())
+  case YT_MAP:
   {
-    VALUE rblist;
-    YCPList list = ycpval->asList();
-    rblist = rb_ary_new2(list.size());
-    //y2internal("list size %d\n",list.size());
-    for (int i=0; i < list.size(); i++)
+    frame.kind = ycp_frame::MAP;
+    YCPMap map = ycpval->asMap();
+    if (proxy && map->size() >= LAZY_CONVERSION_MIN_SIZE)
     {
-      rb_ary_push( rblist, ycpvalue_2_rbvalue(list.value(i)));
+      res = ycp_lazy_proxy(ycpval, Y2RUBY_LAZY_MAP);
+      if (res != Qundef)
+        break;
     }
-    return rblist;
+    // the map is kept alive by frame.value
+    frame.it = map->begin();
+    frame.end = map->end();
+    frame.result = rb_hash_new();
+    break;
   }
-  else if (ycpval->isSymbol())
+  case YT_TERM:
   {
-    YCPSymbol symbol = ycpval->asSymbol();
-    return ID2SYM(rb_intern(symbol->symbol_cstr()));
+    if (NIL_P(y2ruby_class(Y2RUBY_TERM)))
+    {
+      res = Qnil;
+      break;
+    }
+    frame.kind = ycp_frame::TERM;
+    YCPTerm term = ycpval->asTerm();
+    frame.items = term->args();
+    // the params are always a real array, even in lazy mode
+    frame.result = rb_ary_new2(frame.items.size() + 1);
+//we need to pass array of parameters to work properly with unlimited params in ruby
+    rb_ary_push(frame.result, ID2SYM(rb_intern(term->name().c_str())));
+    break;
+  }
+  default:
+    res = convert_single_value(ycpval, type);
+    break;
   }
-  else if (ycpval->isReference())
+
+  if (res == Qundef)
   {
-    return ycp_ref_to_rb_ref(ycpval->asReference());
+    if (NIL_P(pinned))
+      pinned = rb_ary_new();
+    rb_ary_push(pinned, frame.result);
+    stack.push_back(frame);
+    return true;
   }
-  else if (ycpval->isExternal())
+
+  if (conversion.shared)
+    memoize(conversion, rep, res);
+  return false;
+}
+
+/*
+ * next_item
+ *
+ * Returns the next item of the frame to convert, false when all are done.
+ * Maps return their key and then its value.
+ */
+
+static bool
+next_item( const ycp_frame &frame, YCPValue &item )
+{
+  if (frame.kind == ycp_frame::MAP)
   {
-    return ycp_ext_to_rb_ext(ycpval->asExternal());
+    if (frame.it == frame.end)
+      return false;
+
+    item = frame.have_key ? frame.it->second : frame.it->first;
+    return true;
   }
-  else if (ycpval->isCode())
+
+  if (frame.index >= frame.items.size())
+    return false;
+
+  item = frame.items.value(frame.index);
+  return true;
+}
+
+/*
+ * add_item
+ *
+ * Stores the converted item returned by next_item to the frame result
+ */
+
+static void
+add_item( ycp_frame &frame, VALUE item, VALUE pinned )
+{
+  if (frame.kind != ycp_frame::MAP)
   {
-    return ycp_code_to_rb_code(ycpval->asCode());
+    rb_ary_push(frame.result, item);
+    ++frame.index;
   }
-  else if (ycpval->isByteblock())
+  else if (!frame.have_key)
   {
-    return ycp_bb_to_rb_bb(ycpval->asByteblock());
+    // the key is not referenced from the result until its value is done
+    frame.key = item;
+    frame.have_key = true;
+    rb_ary_push(pinned, item);
+  }
+  else
+  {
+    rb_hash_aset(frame.result, frame.key, item);
+    rb_ary_pop(pinned);
+    frame.key = Qnil;
+    frame.have_key = false;
+    ++frame.it;
   }
-  rb_raise( rb_eTypeError, "Conversion of YCP type '%s': %s not supported", Type::vt2type(ycpval->valuetype())->toString().c_str(), ycpval->toString().c_str() );
-  return Qnil;
 }
 
+/*
+ * close_frame
+ *
+ * Returns the converted value of the completed frame
+ */
+
+static VALUE
+close_frame( const ycp_frame &frame, ycp_conversion &conversion )
+{
+  VALUE res = frame.result;
+  if (frame.kind == ycp_frame::TERM)
+    res = rb_class_new_instance(RARRAY_LEN(res), RARRAY_PTR(res), y2ruby_class(Y2RUBY_TERM));
 
+  if (conversion.shared)
+    memoize(conversion, frame.value.operator->(), res);
+  return res;
+}
+
+/*
+ * convert_value
+ *
+ * Converting part of ycpvalue_2_rbvalue. Nested values are walked with
+ * an explicit stack, so the nesting depth is not limited by the C stack.
+ * In the shared mode the strings and collections with the same
+ * representation are converted only once.
+ */
+
+static VALUE
+convert_value( YCPValue ycpval, ycp_conversion &conversion )
+{
+  std::vector<ycp_frame> stack;
+  VALUE pinned = Qnil;
+  VALUE res;
+
+  if (!open_value(ycpval, false, conversion, stack, pinned, res))
+    return res;
+
+  while (true)
+  {
+    YCPValue item = YCPNull();
+    if (next_item(stack.back(), item))
+    {
+      const ycp_frame &frame = stack.back();
+      bool key = frame.kind == ycp_frame::MAP && !frame.have_key;
+      // a new frame is converted first, its result is added when closed
+      if (!open_value(item, key, conversion, stack, pinned, res))
+        add_item(stack.back(), res, pinned);
+      continue;
+    }
+
+    res = close_frame(stack.back(), conversion);
+    stack.pop_back();
+    rb_ary_pop(pinned);
+    if (stack.empty())
+      break;
+
+    add_item(stack.back(), res, pinned);
+  }
+
+  RB_GC_GUARD(pinned);
+  RB_GC_GUARD(conversion.memo_values);
+  return res;
+}
+
+/*
+ * convert_with_flags
+ *
+ * Converts a YCPValue with the conversion flags set in the Yast module,
+ * Yast.lazy_conversion applies only if lazy is allowed
+ */
+static VALUE
+convert_with_flags( YCPValue ycpval, bool allow_lazy )
+{
+  static ID id_lazy = rb_intern("@__lazy_conversion");
+  static ID id_shared = rb_intern("@__shared_conversion");
+  static ID id_interned = rb_intern("@__interned_conversion");
+  static VALUE all = ID2SYM(rb_intern("all"));
+
+  // a redefined class is noticed by the next conversion coming from YCP,
+  // lazy items and nested values reuse the classes already checked
+  y2ruby_classes_revalidate();
+  ycp_conversion conversion;
+  // set by Yast.lazy_conversion, Yast.shared_conversion
+  // and Yast.interned_conversion
+  VALUE yast = y2ruby_yast_module();
+  conversion.lazy = allow_lazy && RTEST(rb_attr_get(yast, id_lazy));
+  conversion.shared = RTEST(rb_attr_get(yast, id_shared));
+  conversion.eager_root = false;
+  VALUE interned = rb_attr_get(yast, id_interned);
+  conversion.intern_keys = RTEST(interned);
+  conversion.intern_values = interned == all;
+  return convert_value(ycpval, conversion);
+}
+
+/**
+ *
+ * ycpvalue_2_rbvalue
+ *
+ * Converts a YCPValue into a Ruby Value
+ * Supports nested lists of any depth.
+ */
+
+extern "C" VALUE
+ycpvalue_2_rbvalue( YCPValue ycpval )
+{
+  return convert_with_flags(ycpval, false);
+}
+
+extern "C" VALUE
+ycpvalue_2_rbvalue_result( YCPValue ycpval )
+{
+  return convert_with_flags(ycpval, true);
+}
+
+extern "C" VALUE
+ycpvalue_2_rbvalue_lazy( YCPValue ycpval )
+{
+  ycp_conversion conversion;
+  conversion.lazy = true;
+  conversion.shared = false;
+  conversion.eager_root = false;
+  conversion.intern_keys = conversion.intern_values = false;
+  return convert_value(ycpval, conversion);
+}
+
+extern "C" VALUE
+ycpvalue_2_rbvalue_shallow( YCPValue ycpval )
+{
+  ycp_conversion conversion;
+  conversion.lazy = true;
+  conversion.shared = false;
+  conversion.eager_root = true;
+  conversion.intern_keys = conversion.intern_values = false;
+  return convert_value(ycpval, conversion);
+}
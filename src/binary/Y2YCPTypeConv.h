@@ -27,9 +27,38 @@ as published by the Free Software Foundation; either version
 
 /**
  * Converts a YCPValue into a Ruby Value
- * Supports neested lists and maps using recursion.
+ * Supports nested lists and maps of any depth.
  */
 extern "C" VALUE
 ycpvalue_2_rbvalue( YCPValue ycpval );
 
+/**
+ * Converts a result returned to Ruby from the component system,
+ * it is lazy in Yast.lazy_conversion unlike ycpvalue_2_rbvalue
+ * used for arguments of callbacks and references
+ */
+extern "C" VALUE
+ycpvalue_2_rbvalue_result( YCPValue ycpval );
+
+/**
+ * Converts a YCPValue into a Ruby Value, big lists and maps
+ * are returned as Yast::LazyList and Yast::LazyMap proxies
+ * converting their items only when accessed
+ */
+extern "C" VALUE
+ycpvalue_2_rbvalue_lazy( YCPValue ycpval );
+
+/**
+ * Converts a YCPList or YCPMap into a Ruby Array or Hash,
+ * its big items are converted lazily like in ycpvalue_2_rbvalue_lazy
+ */
+extern "C" VALUE
+ycpvalue_2_rbvalue_shallow( YCPValue ycpval );
+
+/**
+ * Frees the YCPByteblock wrapped by a Yast::Byteblock
+ */
+extern "C" void
+rb_bb_free( void *p );
+
 #endif
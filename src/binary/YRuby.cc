@@ -163,8 +163,15 @@ YCPValue YRuby::callInner (string module_name, string function,
 {
   string full_name = string("Yast::")+module_name;
   VALUE module = y2ruby_nested_const_get(full_name);
+  return callInner(module, rb_intern(function.c_str()), module_name, argList, wanted_result_type);
+}
+
+YCPValue YRuby::callInner (VALUE module, ID function, const string &module_name,
+                  YCPList argList, constTypePtr wanted_result_type)
+{
   if (module == Qnil)
   {
+    string full_name = string("Yast::")+module_name;
     y2error ("The Ruby module '%s' is not loaded.", full_name.c_str());
     VALUE exception = rb_gv_get("$!"); /* get last exception */
     VALUE reason = rb_funcall(exception, rb_intern("message"), 0 );
@@ -182,7 +189,7 @@ YCPValue YRuby::callInner (string module_name, string function,
   // to pass to protected_call()
   VALUE values[size+3];
   values[0] = module;
-  values[1] = rb_intern(function.c_str());
+  values[1] = function;
   values[2] = size;
   for (int i = 0 ; i < size; ++i )
   {
@@ -194,19 +201,20 @@ YCPValue YRuby::callInner (string module_name, string function,
     values[i+3] = vr;
   }
 
-  y2debug( "Will call function '%s' in module '%s' with '%d' arguments", function.c_str(), module_name.c_str(), size-1);
+  y2debug( "Will call function '%s' in module '%s' with '%d' arguments", rb_id2name(function), module_name.c_str(), size-1);
 
   int error;
   VALUE result = rb_protect(protected_call, (VALUE)values, &error);
   if (error)
   {
+    const char *function_name = rb_id2name(function);
     VALUE exception = rb_gv_get("$!"); /* get last exception */
     VALUE reason = rb_funcall(exception, rb_intern("message"), 0 );
     VALUE trace = rb_gv_get("$@"); /* get last exception trace */
     VALUE backtrace = RARRAY_LEN(trace)>0 ? rb_ary_entry(trace, 0) : rb_str_new2("Unknown");
-    y2error("%s.%s failed:%s at %s", module_name.c_str(), function.c_str(), StringValuePtr(reason),StringValuePtr(backtrace));
+    y2error("%s.%s failed:%s at %s", module_name.c_str(), function_name, StringValuePtr(reason),StringValuePtr(backtrace));
     //workaround if last_exception failed, then return always string with message
-    if(function == "last_exception") //TODO constantify last_exception
+    if(!strcmp(function_name, "last_exception")) //TODO constantify last_exception
     {
       return YCPString(StringValuePtr(reason));
     }
@@ -215,9 +223,13 @@ YCPValue YRuby::callInner (string module_name, string function,
   }
   else
   {
-    y2debug( "Called function '%s' in module '%s'", function.c_str(), module_name.c_str());
+    y2debug( "Called function '%s' in module '%s'", rb_id2name(function), module_name.c_str());
   }
-  return rbvalue_2_ycpvalue(result);
+  bool matches;
+  YCPValue res = rbvalue_2_ycpvalue_typed(result, wanted_result_type, matches);
+  if (!matches)
+    y2debug("%s.%s returned a value not matching its declared type %s", module_name.c_str(), rb_id2name(function), wanted_result_type->toString().c_str());
+  return res;
 }
 
 YCPValue YRuby::callClient(const string& path)
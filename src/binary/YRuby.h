@@ -75,6 +75,12 @@ public:
      **/
     YCPValue callInner (string module, string function, YCPList argList,
       constTypePtr wanted_result_type);
+    /**
+     * Ruby call of an already resolved module and method, module_name
+     * is used only for logging. No string work is done on success.
+     **/
+    YCPValue callInner (VALUE module, ID function, const string &module_name,
+      YCPList argList, constTypePtr wanted_result_type);
     /**
      * Ruby VALUEs do not have a reference count like YCP or Perl.
      * To protect them from being garbage-collected, they must be marked
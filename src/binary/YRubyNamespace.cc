@@ -32,9 +32,17 @@ as published by the Free Software Foundation; either version
 #include <ycp/YCPVoid.h>
 #include <stdio.h>
 #include <exception>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "YRuby.h"
 #include "Y2RubyUtils.h"
+#include "Y2RubyTypeConv.h"
+#include "Y2YCPTypeConv.h"
+#include "Y2RubyClasses.h"
 
 /**
  * Exception raised when type signature in ruby class is invalid
@@ -67,30 +75,37 @@ private:
  */
 class Y2RubyFunction : public Y2Function
 {
+  //! the namespace providing the ruby module
+  YRubyNamespace *m_namespace;
   //! module name
   string m_module_name;
   //! function name, excluding module name
   string m_local_name;
+  //! ruby method of the function
+  ID m_method;
   //! function type
   constFunctionTypePtr m_type;
   //! data prepared for the inner call
   YCPList m_call;
 
 public:
-  Y2RubyFunction (const string &module_name,
+  Y2RubyFunction (YRubyNamespace *name_space,
                   const string &local_name,
                   constFunctionTypePtr function_type
                  ) :
-      m_module_name (module_name),
+      m_namespace (name_space),
+      m_module_name (name_space->name()),
       m_local_name (local_name),
+      m_method (rb_intern(local_name.c_str())),
       m_type (function_type)
   {}
 
   //! called by YEFunction::evaluate
   YCPValue evaluateCall ()
   {
-    return YRuby::yRuby()->callInner ( m_module_name,
-                                       m_local_name,
+    return YRuby::yRuby()->callInner ( m_namespace->rubyModule(),
+                                       m_method,
+                                       m_module_name,
                                        m_call,
                                        m_type->returnType() );
   }
@@ -156,21 +171,40 @@ public:
 class VariableSymbolEntry : public SymbolEntry
 {
 private:
-  const string &module_name;
+  YRubyNamespace *m_namespace;
+  //! ruby accessors of the variable
+  ID m_getter;
+  ID m_setter;
+  //! instance variable behind accessors generated by publish
+  ID m_ivar;
+  VALUE m_symbol;
 public:
   //not so nice constructor that allow us to hook to symbol entry variable reading
-  VariableSymbolEntry(const string &r_module_name, const Y2Namespace* name_space, unsigned int position, const char *name, constTypePtr type) :
-   SymbolEntry(name_space, position, name, SymbolEntry::c_variable, type),module_name(r_module_name)    {}
+  VariableSymbolEntry(YRubyNamespace* name_space, unsigned int position, const char *name, constTypePtr type) :
+   SymbolEntry(name_space, position, name, SymbolEntry::c_variable, type), m_namespace(name_space)
+  {
+    m_getter = rb_intern(name);
+    m_setter = rb_intern((string(name) + "=").c_str());
+    m_ivar = rb_intern((string("@") + name).c_str());
+    // symbols of interned IDs are never collected
+    m_symbol = ID2SYM(m_getter);
+  }
 
   YCPValue setValue (YCPValue value)
   {
+    y2debug("Called set value on %s::%s with %s",m_namespace->name().c_str(), name(), value->toString().c_str());
+    VALUE module = m_namespace->rubyModule();
+    if (m_namespace->hasPlainAccessor(module, m_symbol) && !OBJ_FROZEN(module))
+    {
+      rb_ivar_set(module, m_ivar, ycpvalue_2_rbvalue(value));
+      return value;
+    }
+
     YCPList l;
     l.add(value);
-    string method_name = name();
-    method_name += "=";
-    y2debug("Called set value on %s::%s with %s",module_name.c_str(), name(), value->toString().c_str());
-    return YRuby::yRuby()->callInner ( module_name,
-      method_name,
+    return YRuby::yRuby()->callInner ( module,
+      m_setter,
+      m_namespace->name(),
       l,
       type()
     );
@@ -178,40 +212,225 @@ public:
 
   YCPValue value () const
   {
-    YCPValue result = YRuby::yRuby()->callInner ( module_name,
-      name(),
-      YCPList(),
-      type()
-    );
-    y2debug("Called value on %s::%s and return %s",module_name.c_str(), name(), result->toString().c_str());
+    VALUE module = m_namespace->rubyModule();
+    YCPValue result = YCPNull();
+    if (m_namespace->hasPlainAccessor(module, m_symbol))
+      result = rbvalue_2_ycpvalue(rb_attr_get(module, m_ivar));
+    else
+      result = YRuby::yRuby()->callInner ( module,
+        m_getter,
+        m_namespace->name(),
+        YCPList(),
+        type()
+      );
+    y2debug("Called value on %s::%s and return %s",m_namespace->name().c_str(), name(), result->toString().c_str());
     return result;
   }
 
 };
 
-void YRubyNamespace::constructSymbolTable(VALUE module)
+/**
+ * Reads the exports of the module, see Yast::Exportable#export_table.
+ * Returns false if the module does not publish anything.
+ */
+static bool moduleExports(VALUE module, YRubyExports &functions, YRubyExports &variables)
 {
-  int offset = 0; //track number of added method, so we can add extra one at the end
   VALUE module_class = rb_obj_class(module);
-  if (rb_respond_to(module_class, rb_intern("published_functions" )))
+  if (!rb_respond_to(module_class, rb_intern("export_table" )))
+    return false;
+
+  VALUE exports = rb_funcall(module_class, rb_intern("export_table"), 0);
+  for (int kind = 0; kind < 2; ++kind)
   {
-    offset = addMethods(module_class);
-    offset = addVariables(module_class, offset);
+    VALUE table = rb_ary_entry(exports, kind);
+    YRubyExports &result = kind == 0 ? functions : variables;
+    for (long i = 0; i < RARRAY_LEN(table); ++i)
+    {
+      // [name, type, private]
+      VALUE entry = RARRAY_AREF(table, i);
+      VALUE type = RARRAY_AREF(entry, 1);
+      YRubyExport e;
+      e.name = rb_id2name(SYM2ID(RARRAY_AREF(entry, 0)));
+      e.signature = StringValueCStr(type);
+      e.is_private = RTEST(RARRAY_AREF(entry, 2));
+      result.push_back(e);
+    }
   }
-  else
+  return true;
+}
+
+/**
+ * Parses the type signature, each distinct signature only once
+ * per process. Returns NULL for an invalid signature.
+ */
+static constTypePtr parsedSignature(const string &signature)
+{
+  static map<string, constTypePtr> parsed;
+  map<string, constTypePtr>::iterator it = parsed.find(signature);
+  if (it != parsed.end())
+    return it->second;
+
+  constTypePtr type = Type::fromSignature(signature);
+  if (type != NULL)
+    parsed.insert(make_pair(signature, type));
+  return type;
+}
+
+/**
+ * Path of the manifest of the module exports,
+ * empty if the manifest cache is not enabled
+ */
+static string manifestPath(const string &name)
+{
+  const char *dir = getenv("Y2RUBY_MANIFEST_DIR");
+  if (dir == NULL || *dir == '\0')
+    return "";
+
+  string file = name;
+  for (string::size_type i = file.find("::"); i != string::npos; i = file.find("::", i))
+    file.replace(i, 2, "-");
+  return string(dir) + "/" + file + ".manifest";
+}
+
+/**
+ * Identifies the version of the module file, a manifest with another key
+ * is out of date. Empty if the file is missing.
+ */
+static string manifestKey(const string &module_path)
+{
+  string source = module_path + ".rb";
+  struct stat st;
+  if (stat(source.c_str(), &st) != 0)
+    return "";
+
+  ostringstream key;
+  key << source << ' ' << st.st_mtime << ' ' << st.st_size;
+  return key.str();
+}
+
+/**
+ * Manifest format: the key line, then a line for each export:
+ * "f" or "v" (function or variable), 1 if private else 0, name and
+ * the signature, which takes the rest of the line
+ */
+static bool readManifest(const string &file, const string &key,
+  YRubyExports &functions, YRubyExports &variables)
+{
+  ifstream in(file.c_str());
+  string line;
+  if (!getline(in, line) || line != key)
+    return false;
+
+  while (getline(in, line))
   {
-    y2error("Module '%s' doesn't export anything. DEPRECATED old way", m_name.c_str());
-    return;
+    istringstream entry(line);
+    char kind;
+    YRubyExport e;
+    bool valid = entry >> kind >> e.is_private >> e.name
+      && getline(entry >> ws, e.signature)
+      && (kind == 'f' || kind == 'v');
+    constTypePtr type = valid ? parsedSignature(e.signature) : constTypePtr();
+    if (type == NULL || type->isFunction() != (kind == 'f'))
+    {
+      // the module is imported as usual and writes a new manifest
+      y2warning("Broken manifest %s, removing it", file.c_str());
+      unlink(file.c_str());
+      return false;
+    }
+    (kind == 'f' ? functions : variables).push_back(e);
+  }
+  return true;
+}
+
+static void writeManifestExports(ostream &out, char kind, const YRubyExports &exports)
+{
+  for (YRubyExports::const_iterator i = exports.begin(); i != exports.end(); ++i)
+    out << kind << ' ' << i->is_private << ' ' << i->name << ' ' << i->signature << '\n';
+}
+
+static void writeManifest(const string &file, const string &key,
+  const YRubyExports &functions, const YRubyExports &variables)
+{
+  // write a private file and rename it, readers never see a partial manifest
+  ostringstream tmp;
+  tmp << file << '.' << getpid();
+  string tmp_file = tmp.str();
+  ofstream out(tmp_file.c_str());
+  out << key << '\n';
+  writeManifestExports(out, 'f', functions);
+  writeManifestExports(out, 'v', variables);
+  out.close();
+
+  if (!out || rename(tmp_file.c_str(), file.c_str()) != 0)
+  {
+    y2warning("Cannot write manifest %s", file.c_str());
+    unlink(tmp_file.c_str());
+  }
+}
+
+/**
+ * Records the modules imported from a manifest and not required yet
+ * in Yast @__lazy_modules, Yast.import requires them right away
+ */
+static void setLazyModule(const string &name, const string &module_path)
+{
+  static ID id_lazy = rb_intern("@__lazy_modules");
+  VALUE yast = y2ruby_yast_module();
+  VALUE lazy = rb_attr_get(yast, id_lazy);
+  if (NIL_P(lazy))
+  {
+    lazy = rb_hash_new();
+    rb_ivar_set(yast, id_lazy, lazy);
   }
-  addExceptionMethod(module,offset);
+
+  VALUE key = rb_str_new2(name.c_str());
+  if (module_path.empty())
+    rb_hash_delete(lazy, key);
+  else
+    rb_hash_aset(lazy, key, rb_str_new2(module_path.c_str()));
+}
+
+void YRubyNamespace::constructSymbolTable(const YRubyExports &functions, const YRubyExports &variables)
+{
+  int offset = 0; //track number of added method, so we can add extra one at the end
+  bool all_global = getenv("Y2ALLGLOBAL") != NULL;
+  offset = addMethods(functions, all_global);
+  offset = addVariables(variables, all_global, offset);
+  addExceptionMethod(Qnil, offset);
   y2debug("%s", symbolsToString().c_str());
 }
 
+void YRubyNamespace::bindModule(VALUE module)
+{
+  if (NIL_P(module))
+    return;
 
-YRubyNamespace::YRubyNamespace (string name)
+  VALUE module_class = rb_obj_class(module);
+  if (rb_respond_to(module_class, rb_intern("published_accessors")))
+  {
+    m_accessors_class = module_class;
+    m_accessors = rb_funcall(module_class, rb_intern("published_accessors"), 0);
+  }
+}
+
+void YRubyNamespace::init()
+{
+  y2debug("Creating namespace for '%s'", m_name.c_str());
+  m_module = Qnil;
+  m_parent = Qnil;
+  m_const_id = 0;
+  m_accessors_class = Qnil;
+  m_accessors = Qnil;
+  rb_gc_register_address(&m_module);
+  rb_gc_register_address(&m_parent);
+  rb_gc_register_address(&m_accessors_class);
+  rb_gc_register_address(&m_accessors);
+}
+
+YRubyNamespace::YRubyNamespace (string name, const string &module_path)
     : m_name (name)
 {
-  y2debug("Creating namespace for '%s'", name.c_str());
+  init();
 
   VALUE module = getRubyModule();
   if (module == Qnil)
@@ -220,11 +439,68 @@ YRubyNamespace::YRubyNamespace (string name)
     return;
   }
 
-  constructSymbolTable(module);
+  YRubyExports functions, variables;
+  if (!moduleExports(module, functions, variables))
+  {
+    y2error("Module '%s' doesn't export anything. DEPRECATED old way", m_name.c_str());
+    return;
+  }
+  constructSymbolTable(functions, variables);
+  bindModule(module);
+
+  string manifest = module_path.empty() ? "" : manifestPath(name);
+  string key = manifest.empty() ? "" : manifestKey(module_path);
+  if (!key.empty())
+    writeManifest(manifest, key, functions, variables);
+}
+
+YRubyNamespace::YRubyNamespace (string name, const string &module_path,
+  const YRubyExports &functions, const YRubyExports &variables)
+    : m_name (name), m_module_path (module_path)
+{
+  init();
+  constructSymbolTable(functions, variables);
+  setLazyModule(name, module_path);
+}
+
+YRubyNamespace *YRubyNamespace::fromManifest (string name, const string &module_path)
+{
+  string manifest = manifestPath(name);
+  if (manifest.empty())
+    return NULL;
+
+  string key = manifestKey(module_path);
+  YRubyExports functions, variables;
+  if (key.empty() || !readManifest(manifest, key, functions, variables))
+    return NULL;
+
+  y2debug("Namespace '%s' created from manifest %s", name.c_str(), manifest.c_str());
+  YRuby::yRuby();
+  return new YRubyNamespace(name, module_path, functions, variables);
+}
+
+void YRubyNamespace::loadModule()
+{
+  string module_path = m_module_path;
+  m_module_path.clear();
+  setLazyModule(m_name, "");
+
+  y2debug("Requiring module '%s' on first use", m_name.c_str());
+  YCPList args;
+  args->add (YCPString(m_name));
+  args->add (YCPString(module_path));
+  YRuby::loadModule (args);
+  // a missing module is reported by the call
+  bindModule(getRubyModule());
 }
 
 YRubyNamespace::~YRubyNamespace ()
-{}
+{
+  rb_gc_unregister_address(&m_module);
+  rb_gc_unregister_address(&m_parent);
+  rb_gc_unregister_address(&m_accessors_class);
+  rb_gc_unregister_address(&m_accessors);
+}
 
 const string YRubyNamespace::filename () const
 {
@@ -261,67 +537,79 @@ Y2Function* YRubyNamespace::createFunctionCall (const string name, constFunction
   }
 
   constTypePtr t = required_type ? required_type : (constFunctionTypePtr)func_te->sentry()->type ();
-  return new Y2RubyFunction (m_name, name, t);
+  return new Y2RubyFunction (this, name, t);
 }
 
 VALUE YRubyNamespace::getRubyModule()
 {
   ruby_module_name = string("Yast::") + m_name;
-  VALUE module = y2ruby_nested_const_get(ruby_module_name);
-  return module;
+  m_module = y2ruby_nested_const_get(ruby_module_name);
+
+  // remember where the constant is, to notice its reassignment cheaply
+  string::size_type separator = ruby_module_name.rfind("::");
+  m_parent = y2ruby_nested_const_get(ruby_module_name.substr(0, separator));
+  m_const_id = rb_intern(ruby_module_name.substr(separator + 2).c_str());
+  return m_module;
+}
+
+VALUE YRubyNamespace::rubyModule()
+{
+  if (!m_module_path.empty())
+    loadModule();
+  else if (!NIL_P(m_parent) && rb_const_defined_at(m_parent, m_const_id))
+    m_module = rb_const_get_at(m_parent, m_const_id);
+  return m_module;
+}
+
+bool YRubyNamespace::hasPlainAccessor(VALUE module, VALUE variable)
+{
+  // a singleton class (e.g. from a test double) may override the accessor
+  if (NIL_P(m_accessors) || CLASS_OF(module) != m_accessors_class)
+    return false;
+
+  return RTEST(rb_hash_lookup(m_accessors, variable));
 }
 
-int YRubyNamespace::addMethods(VALUE module)
+int YRubyNamespace::addMethods(const YRubyExports &functions, bool all_global)
 {
-  VALUE methods = rb_funcall(module, rb_intern("published_functions"),0);
-  methods = rb_funcall(methods,rb_intern("values"),0);
   int j = 0;
-  for (int i = 0; i < RARRAY_LEN(methods); ++i)
+  for (YRubyExports::const_iterator i = functions.begin(); i != functions.end(); ++i)
   {
-    VALUE method = rb_ary_entry(methods,i);
-    if (getenv("Y2ALLGLOBAL") == NULL && RTEST(rb_funcall(method, rb_intern("private?"), 0)))
+    if (!all_global && i->is_private)
       continue;
-    VALUE method_name = rb_funcall(method, rb_intern("function"), 0);
-    VALUE type = rb_funcall(method,rb_intern("type"),0);
-    string signature = StringValueCStr(type);
 
-    addMethod(rb_id2name(SYM2ID(method_name)), signature, j++);
+    addMethod(i->name.c_str(), i->signature, j++);
   }
   return j;
 }
 
-int YRubyNamespace::addVariables(VALUE module, int offset)
+int YRubyNamespace::addVariables(const YRubyExports &variables, bool all_global, int offset)
 {
-  VALUE variables = rb_funcall(module, rb_intern("published_variables"),0);
-  variables = rb_funcall(variables,rb_intern("values"),0);
   int j=0;
-  for (int i = 0; i < RARRAY_LEN(variables); ++i)
+  for (YRubyExports::const_iterator i = variables.begin(); i != variables.end(); ++i)
   {
-    VALUE variable = rb_ary_entry(variables,i);
-    VALUE variable_name = rb_funcall(variable, rb_intern("variable"), 0);
-    if (getenv("Y2ALLGLOBAL") == NULL && RTEST(rb_funcall(variable, rb_intern("private?"), 0)))
+    const char *variable_name = i->name.c_str();
+    if (!all_global && i->is_private)
     {
-      y2debug("variable: '%s' is private and not needed", rb_id2name(SYM2ID(variable_name)));
+      y2debug("variable: '%s' is private and not needed", variable_name);
       continue;
     }
-    VALUE type = rb_funcall(variable,rb_intern("type"),0);
-    string signature = StringValueCStr(type);
-    constTypePtr sym_tp = Type::fromSignature(signature);
+    const string &signature = i->signature;
+    constTypePtr sym_tp = parsedSignature(signature);
 
     if (sym_tp == NULL)
-      throw WrongTypeException(rb_id2name(SYM2ID(variable_name)), signature);
+      throw WrongTypeException(variable_name, signature);
 
     // symbol entry for the function
-    SymbolEntry *se = new VariableSymbolEntry ( ruby_module_name,
-      this,
+    SymbolEntry *se = new VariableSymbolEntry ( this,
       offset+(j++),// position. arbitrary numbering. must stay consistent when?
-      rb_id2name(SYM2ID(variable_name)),
+      variable_name,
       sym_tp
     );
     se->setGlobal (true);
     // enter it to the symbol table
     enterSymbol (se, 0);
-    y2debug("variable: '%s' added", rb_id2name(SYM2ID(variable_name)));
+    y2debug("variable: '%s' added", variable_name);
   }
   return offset+j;
 }
@@ -334,7 +622,7 @@ int YRubyNamespace::addExceptionMethod(VALUE module, int offset)
 
 void YRubyNamespace::addMethod( const char* name, const string &signature, int offset)
 {
-  constTypePtr sym_tp = Type::fromSignature(signature);
+  constTypePtr sym_tp = parsedSignature(signature);
   if (sym_tp == NULL || !sym_tp->isFunction())
     throw WrongTypeException(name, signature);
 
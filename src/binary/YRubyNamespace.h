@@ -24,6 +24,20 @@ as published by the Free Software Foundation; either version
 #include <y2/Y2Function.h>
 #include <ycp/YStatement.h>
 
+#include <vector>
+
+/**
+ * Function or variable published by a Ruby module
+ */
+struct YRubyExport
+{
+    string name;
+    string signature;
+    bool is_private;
+};
+
+typedef std::vector<YRubyExport> YRubyExports;
+
 /**
  * YaST interface to a Ruby module
  */
@@ -32,19 +46,41 @@ class YRubyNamespace : public Y2Namespace
 private:
     string m_name;		//! this namespace's name, eg. XML::Writer
     string ruby_module_name;
+    VALUE m_module;		//! the ruby object, GC pinned
+    VALUE m_parent;		//! the module defining m_module constant
+    ID m_const_id;		//! name of the m_module constant
+    VALUE m_accessors_class;	//! class with generated variable accessors
+    VALUE m_accessors;		//! its published_accessors hash
+    string m_module_path;	//! path of a module not required yet, see fromManifest
     VALUE getRubyModule(); //sets ruby_module name as sideeffect, so we know what is real name in ruby
-    void constructSymbolTable(VALUE module);
-    int addMethods(VALUE module);
-    int addVariables(VALUE module,int offset);
+    void init();
+    void bindModule(VALUE module);
+    void loadModule();
+    void constructSymbolTable(const YRubyExports &functions, const YRubyExports &variables);
+    int addMethods(const YRubyExports &functions, bool all_global);
+    int addVariables(const YRubyExports &variables, bool all_global, int offset);
     int addExceptionMethod(VALUE module, int offset);
     void addMethod(const char *name, const string &signature, int offset);
+    YRubyNamespace (string name, const string &module_path,
+      const YRubyExports &functions, const YRubyExports &variables);
 
 public:
     /**
      * Construct an interface. The module must be already loaded
      * @param name eg "XML::Writer"
+     * @param module_path path of the module file without ".rb", if given
+     *   the exports are stored in the manifest cache when it is enabled
+     */
+    YRubyNamespace (string name, const string &module_path = "");
+
+    /**
+     * Construct an interface from the cached manifest of the module exports.
+     * The module is required only when it is used for the first time.
+     * The cache is enabled by the Y2RUBY_MANIFEST_DIR environment variable.
+     * @param module_path path of the module file without ".rb"
+     * @return NULL if the cache is disabled or there is no up to date manifest
      */
-    YRubyNamespace (string name);
+    static YRubyNamespace *fromManifest (string name, const string &module_path);
 
     virtual ~YRubyNamespace ();
 
@@ -63,4 +99,19 @@ public:
     virtual void initialize () {}
 
     virtual Y2Function* createFunctionCall (const string name, constFunctionTypePtr requiredType);
+
+    /**
+     * The ruby object implementing the namespace, resolved when the
+     * namespace is created. It is resolved again only if the constant
+     * gets reassigned, that check needs no string work.
+     */
+    VALUE rubyModule();
+
+    /**
+     * Does the module still use the accessor generated by Exportable#publish
+     * for the variable? Then its instance variable can be used directly.
+     * @param module the result of rubyModule()
+     * @param variable symbol of the variable
+     */
+    bool hasPlainAccessor(VALUE module, VALUE variable);
 };
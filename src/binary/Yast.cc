@@ -35,14 +35,21 @@ as published by the Free Software Foundation; either version
 #include <ycp/YCPVoid.h>
 #include <ycp/YCPCode.h>
 #include <ycp/YCPByteblock.h>
+#include <ycp/YCPList.h>
+#include <ycp/YCPMap.h>
 #include <ycp/Import.h>
 #include <ycp/y2log.h>
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "ruby.h"
 
 #include "Y2YCPTypeConv.h"
 #include "Y2RubyTypeConv.h"
 #include "Y2RubyUtils.h"
+#include "Y2RubyClasses.h"
 
 /*
  * Ruby module anchors
@@ -52,6 +59,81 @@ static VALUE rb_mYast;
 static VALUE rb_cYReference;
 static VALUE rb_cByteblock;
 static VALUE rb_cYCode;
+static VALUE rb_cLazyList;
+static VALUE rb_cLazyMap;
+
+static VALUE rb_cCallSite;
+
+// pooled calls of the call sites collected by the GC; a finalizer can run
+// after the components are gone, so they are deleted on the next call
+// of any site, at exit they are left to the process
+static std::vector<Y2Function *> released_calls;
+
+/*
+ * Resolved YCP symbol, see Yast.call_site
+ */
+struct call_site
+{
+  std::string namespace_name;
+  std::string symbol_name;
+  Y2Namespace *ns;
+  TableEntry *entry;
+  //! namespace_generation when resolved
+  unsigned long generation;
+  //! reset function calls ready for reuse, a call being evaluated
+  //! is not here, so recursive calls of the site get another one
+  std::vector<Y2Function *> calls;
+  //! variable value last read in Yast.cached_variables and its frozen
+  //! conversion, holding the value keeps its identity unique
+  YCPValue cached_value;
+  VALUE cached_rb;
+
+  call_site() :
+    ns(NULL), entry(NULL), generation(0),
+    cached_value(YCPNull()), cached_rb(Qnil)
+  {}
+
+  ~call_site()
+  {
+    clear_calls();
+  }
+
+  void clear_cache()
+  {
+    cached_value = YCPNull();
+    cached_rb = Qnil;
+  }
+
+  void clear_calls()
+  {
+    for (size_t i = 0; i < calls.size(); ++i)
+      delete calls[i];
+    calls.clear();
+  }
+
+  void release_calls()
+  {
+    released_calls.insert(released_calls.end(), calls.begin(), calls.end());
+    calls.clear();
+  }
+};
+
+static void
+delete_released_calls()
+{
+  for (size_t i = 0; i < released_calls.size(); ++i)
+    delete released_calls[i];
+  released_calls.clear();
+}
+
+// more reset calls of one site are deleted, only deep recursion needs them
+#define CALL_SITE_MAX_CALLS 4
+
+// bumped when an import finds another namespace than before for a name
+// and when the search paths change, the resolved call sites are valid
+// only in the generation they were resolved in
+static unsigned long namespace_generation = 0;
+static std::map<std::string, Y2Namespace *> imported_namespaces;
 
 extern "C" {
 
@@ -66,6 +148,10 @@ getNs (const char * ns_name)
   }
   else
   {
+    Y2Namespace *&known = imported_namespaces[ns_name];
+    if (known != NULL && known != ns)
+      ++namespace_generation;
+    known = ns;
     ns->initialize ();
   }
   return ns;
@@ -115,7 +201,7 @@ static VALUE
 ycp_find_include_file( VALUE self, VALUE path)
 {
   string ipath (StringValuePtr(path));
-  string include_path = YCPPathSearch::find (YCPPathSearch::Include, ipath);
+  string include_path = y2ruby_find_path (YCPPathSearch::Include, ipath);
   if (include_path.empty())
     rb_raise(rb_eRuntimeError, "Cannot find client %s", ipath.c_str());
 
@@ -167,34 +253,23 @@ void set_ruby_source_location(VALUE file, VALUE lineno)
 }
 
 /*
- * call_ycp_function
- *
- * Forwards a ruby call to the namespace
- *
- * First argument is the namespace
- * then function name and arguments
+ * resolve_call_site
  *
+ * Finds the namespace and the symbol of the call site unless
+ * it is already resolved in the current namespace_generation
  */
-
-static VALUE
-ycp_module_call_ycp_function(int argc, VALUE *argv, VALUE self)
+static void
+resolve_call_site( call_site &site )
 {
-  const char *namespace_name = StringValuePtr(argv[0]);
-  const char *function_name;
-  VALUE symbol = argv[1];
-
-  if (SYMBOL_P(symbol))
-    function_name = (const char *)rb_id2name( SYM2ID( symbol ) );
-  else
-    function_name = StringValuePtr( symbol );
-
-  y2debug("Dynamic Proxy: [%s::%s] with [%d] params\n", namespace_name, function_name, argc);
+  if (site.ns != NULL && site.generation == namespace_generation)
+    return;
 
+  const char *namespace_name = site.namespace_name.c_str();
+  const char *function_name = site.symbol_name.c_str();
   Y2Namespace *ns = getNs(namespace_name);
   if (ns == NULL)
   {
     rb_raise( rb_eRuntimeError, "Component cannot import namespace '%s' for symbol '%s'", namespace_name, function_name );
-    return Qnil;
   }
 
   y2debug("Namespace created from %s\n", ns->filename().c_str());
@@ -205,66 +280,575 @@ ycp_module_call_ycp_function(int argc, VALUE *argv, VALUE self)
   {
     y2internal ("No such symbol %s::%s", namespace_name, function_name);
     rb_raise( rb_eNameError, "YCP symbol '%s' not found in namespace '%s'", function_name, namespace_name );
-    return Qnil;
   }
 
-  if (sym_te->sentry ()->isVariable () ||
-      sym_te->sentry ()->isReference ())
+  // the calls and the cached value belong to the previous namespace
+  site.clear_calls();
+  site.clear_cache();
+  site.ns = ns;
+  site.entry = sym_te;
+  site.generation = namespace_generation;
+}
+
+static bool
+call_site_is_variable( const call_site &site )
+{
+  return site.entry->sentry()->isVariable() || site.entry->sentry()->isReference();
+}
+
+/*
+ * deep_freeze
+ *
+ * Freezes the converted value including all its items
+ */
+static VALUE
+deep_freeze( VALUE value )
+{
+  static ID id_params = rb_intern("@params");
+  VALUE term = y2ruby_class(Y2RUBY_TERM);
+  std::vector<VALUE> pending(1, value);
+  while (!pending.empty())
+  {
+    VALUE v = pending.back();
+    pending.pop_back();
+    if (SPECIAL_CONST_P(v) || OBJ_FROZEN(v))
+      continue;
+
+    switch (TYPE(v))
+    {
+      case T_ARRAY:
+        for (long i = 0; i < RARRAY_LEN(v); ++i)
+          pending.push_back(rb_ary_entry(v, i));
+        break;
+      case T_HASH:
+        {
+          VALUE keys = rb_funcall(v, rb_intern("keys"), 0);
+          for (long i = 0; i < RARRAY_LEN(keys); ++i)
+          {
+            VALUE key = rb_ary_entry(keys, i);
+            pending.push_back(key);
+            pending.push_back(rb_hash_aref(v, key));
+          }
+        }
+        break;
+      case T_OBJECT:
+        // Yast::Term keeps its items in an array
+        if (!NIL_P(term) && RTEST(rb_obj_is_kind_of(v, term)))
+          pending.push_back(rb_attr_get(v, id_params));
+        break;
+    }
+    rb_obj_freeze(v);
+  }
+  return value;
+}
+
+/*
+ * call_site_read_variable
+ *
+ * Reads the variable of the site. In Yast.cached_variables the converted
+ * value is frozen and kept in the site; it is returned again as long as
+ * the variable refers to the same YCP value. The site holds that value,
+ * so it is shared and libycp copies it before any change.
+ */
+static VALUE
+call_site_read_variable( call_site &site )
+{
+  static ID id_cached = rb_intern("@__cached_variables");
+  static ID id_lazy = rb_intern("@__lazy_conversion");
+  YCPValue value = site.entry->sentry()->value();
+  // lazy proxies convert on access, they cannot be frozen
+  if (!RTEST(rb_attr_get(rb_mYast, id_cached)) || RTEST(rb_attr_get(rb_mYast, id_lazy)))
+    return ycpvalue_2_rbvalue_result(value);
+
+  if (!site.cached_value.isNull() && site.cached_value.refersToSameElementAs(value))
+    return site.cached_rb;
+
+  VALUE res = deep_freeze(ycpvalue_2_rbvalue(value));
+  site.cached_value = value;
+  site.cached_rb = res;
+  return res;
+}
+
+/*
+ * Arguments and results of one function call of a site, converted
+ * under rb_protect by call_site_invoke
+ */
+struct call_site_args
+{
+  call_site *site;
+  int argc;
+  VALUE *argv;
+  //! the converted arguments
+  YCPList *params;
+  //! the result of the call and its conversion
+  YCPValue *result;
+  VALUE res;
+  //! Yast::ArgRef arguments and their new values, alternating
+  VALUE refs;
+};
+
+static VALUE
+convert_call_params( VALUE data )
+{
+  call_site_args *args = (call_site_args *) data;
+  call_site &site = *args->site;
+  constFunctionTypePtr type = (constFunctionTypePtr) site.entry->sentry()->type();
+  for (int i=0; i < args->argc; i++)
+  {
+    constTypePtr wanted = i < type->parameterCount() ? type->parameterType(i) : constTypePtr();
+    bool matches;
+    YCPValue v = rbvalue_2_ycpvalue_typed(args->argv[i], wanted, matches);
+    if (!matches)
+      y2debug("Parameter %d of %s::%s does not match its declared type %s", i+1, site.namespace_name.c_str(), site.symbol_name.c_str(), wanted->toString().c_str());
+    y2debug("Append parameter %s", v->toString().c_str());
+    args->params->add(v);
+  }
+  return Qnil;
+}
+
+static VALUE
+convert_call_result( VALUE data )
+{
+  call_site_args *args = (call_site_args *) data;
+  for (int i=0; i < args->argc; i++)
+  {
+    //handle args passed by references
+    if (strcmp(rb_obj_classname(args->argv[i]), "Yast::ArgRef"))
+      continue;
+
+    SymbolEntryPtr entry = (*args->params)->value(i)->asReference()->entry();
+    if (NIL_P(args->refs))
+      args->refs = rb_ary_new();
+    rb_ary_push(args->refs, args->argv[i]);
+    rb_ary_push(args->refs, ycpvalue_2_rbvalue(entry->value()));
+  }
+  args->res = ycpvalue_2_rbvalue_result(*args->result);
+  return Qnil;
+}
+
+/*
+ * call_site_invoke
+ *
+ * Calls the resolved symbol. A variable is read without arguments
+ * and set with one. A function gets its arguments, the ruby source
+ * location of the call must be already set.
+ *
+ * A function call is taken from the pool only when the arguments are
+ * converted and it is back before the result is converted. The
+ * conversions run under rb_protect and their errors are raised again
+ * once the YCP values are freed, so nothing leaks when they fail.
+ */
+static VALUE
+call_site_invoke( call_site &site, int argc, VALUE *argv )
+{
+  const char *function_name = site.symbol_name.c_str();
+  TableEntry *sym_te = site.entry;
+  Y2Namespace *ns = site.ns;
+
+  if (call_site_is_variable(site))
   {
     y2debug ("Variable or reference %s\n", function_name);
     //get
-    if (argc==2)
-      return ycpvalue_2_rbvalue(sym_te->sentry()->value());
+    if (argc==0)
+      return call_site_read_variable(site);
     // set the variable
     else
     {
-      sym_te->sentry()->setValue(rbvalue_2_ycpvalue(argv[2]));
-      return argv[2];
+      site.clear_cache();
+      sym_te->sentry()->setValue(rbvalue_2_ycpvalue(argv[0]));
+      return argv[0];
     }
   }
   else
   { // no indent yet
-    Y2Function* call = ns->createFunctionCall(function_name, 0 /*Type::fromSignature(signature)*/);
+    delete_released_calls();
 
-    if (call == NULL)
+    int state = 0;
+    bool created = true;
+    call_site_args args = { &site, argc, argv, NULL, NULL, Qnil, Qnil };
     {
-      y2internal ("cannot create function call %s\n", function_name);
-      rb_raise( rb_eRuntimeError, "can't create call to %s::%s", namespace_name, function_name);
-    }
-
-    y2debug("Call %s", function_name);
-    std::map<int,SymbolEntryPtr> refs;
-    // add the parameters
-    for (int i=4; i < argc; i++)
-    {
-      YCPValue v = rbvalue_2_ycpvalue(argv[i]);
-      y2debug("Append parameter %s", v->toString().c_str());
+      YCPList params;
+      YCPValue result = YCPNull();
+      args.params = &params;
+      args.result = &result;
+      rb_protect(convert_call_params, (VALUE) &args, &state);
+
+      Y2Function* call = NULL;
+      if (!state)
+      {
+        if (site.calls.empty())
+          call = site.ns->createFunctionCall(function_name, 0 /*Type::fromSignature(signature)*/);
+        else
+        {
+          call = site.calls.back();
+          site.calls.pop_back();
+        }
+        created = call != NULL;
+      }
 
-      const char *class_name = rb_obj_classname(argv[i]);
-      //handle args passed by references
-      if (!strcmp(class_name, "Yast::ArgRef"))
+      if (call != NULL)
       {
-        refs[i] = v->asReference()->entry();
+        y2debug("Call %s", function_name);
+        // add the parameters
+        for (int i=0; i < argc; i++)
+          call->appendParameter (params->value(i));
+        call->finishParameters ();
+
+        result = call->evaluateCall ();
+        // reuse the call unless the site got resolved again meanwhile
+        if (site.ns == ns && site.calls.size() < CALL_SITE_MAX_CALLS && call->reset())
+          site.calls.push_back(call);
+        else
+          delete call;
+
+        rb_protect(convert_call_result, (VALUE) &args, &state);
       }
-      call->appendParameter (v);
     }
-    call->finishParameters ();
+    if (state)
+      rb_jump_tag(state);
+    if (!created)
+    {
+      y2internal ("cannot create function call %s\n", function_name);
+      rb_raise( rb_eRuntimeError, "can't create call to %s::%s", site.namespace_name.c_str(), function_name);
+    }
 
-    set_ruby_source_location(argv[2], argv[3]);
+    //set back references
+    for (long i = 0; !NIL_P(args.refs) && i < RARRAY_LEN(args.refs); i += 2)
+      rb_funcall(RARRAY_AREF(args.refs, i), rb_intern("value="), 1, RARRAY_AREF(args.refs, i + 1));
+    RB_GC_GUARD(args.refs);
+    RB_GC_GUARD(args.res);
+    return args.res;
+  }
+}
 
-    YCPValue res = call->evaluateCall ();
-    delete call;
-    for (std::map<int,SymbolEntryPtr>::iterator i = refs.begin(); i != refs.end(); ++i)
+/*
+ * call_site_invoke_located
+ *
+ * Like call_site_invoke, but a function gets the ruby file and line
+ * of the caller before its arguments
+ */
+static VALUE
+call_site_invoke_located( call_site &site, int argc, VALUE *argv )
+{
+  if (call_site_is_variable(site))
+    return call_site_invoke(site, argc, argv);
+
+  if (argc < 2)
+    rb_raise( rb_eArgError, "missing caller location for %s::%s", site.namespace_name.c_str(), site.symbol_name.c_str() );
+
+  set_ruby_source_location(argv[0], argv[1]);
+  return call_site_invoke(site, argc-2, argv+2);
+}
+
+static void
+init_call_site( call_site &site, VALUE namespace_name, VALUE symbol )
+{
+  site.namespace_name = StringValuePtr(namespace_name);
+  if (SYMBOL_P(symbol))
+    site.symbol_name = rb_id2name( SYM2ID( symbol ) );
+  else
+    site.symbol_name = StringValuePtr( symbol );
+}
+
+/*
+ * call_ycp_function
+ *
+ * Forwards a ruby call to the namespace
+ *
+ * First argument is the namespace
+ * then function name and arguments
+ *
+ */
+
+static VALUE
+ycp_module_call_ycp_function(int argc, VALUE *argv, VALUE self)
+{
+  call_site site;
+  init_call_site(site, argv[0], argv[1]);
+
+  y2debug("Dynamic Proxy: [%s::%s] with [%d] params\n", site.namespace_name.c_str(), site.symbol_name.c_str(), argc);
+
+  resolve_call_site(site);
+  return call_site_invoke_located(site, argc-2, argv+2);
+}
+
+static void
+call_site_mark( void *p )
+{
+  rb_gc_mark(((call_site *) p)->cached_rb);
+}
+
+static void
+call_site_free( void *p )
+{
+  call_site *site = (call_site *) p;
+  site->release_calls();
+  delete site;
+}
+
+/*
+ * Document-method: call_site(namespace, symbol)
+ * call-seq:
+ *   Yast.call_site("Namespace", :symbol) -> Yast::CallSite
+ *
+ * Returns handle calling the given symbol. The namespace and the symbol
+ * are looked up only on the first call and again only if the namespace
+ * gets replaced, so repeated calls go straight to the conversion of
+ * the arguments. Used by the wrappers created by Yast.import.
+ */
+static VALUE
+ycp_module_call_site( VALUE self, VALUE namespace_name, VALUE symbol )
+{
+  call_site *site = new call_site;
+  // wrapped first, the site is freed by the GC if the names are invalid
+  VALUE res = Data_Wrap_Struct(rb_cCallSite, call_site_mark, call_site_free, site);
+  init_call_site(*site, namespace_name, symbol);
+  return res;
+}
+
+/*
+ * Document-method: Yast::CallSite#call
+ * call-seq:
+ *   call -> value of the variable
+ *   call(value) -> value
+ *   call(file, line, *args) -> result of the function
+ *
+ * Arguments are the same as for Yast.call_yast_function without
+ * the namespace and the symbol.
+ */
+static VALUE
+call_site_call( int argc, VALUE *argv, VALUE self )
+{
+  call_site *site;
+  Data_Get_Struct(self, call_site, site);
+  resolve_call_site(*site);
+  return call_site_invoke_located(*site, argc, argv);
+}
+
+/*
+ * imported_call_site
+ *
+ * Returns the call site of the imported method being called
+ */
+static call_site *
+imported_call_site( VALUE module )
+{
+  static ID id_sites = rb_intern("__call_sites");
+  ID method = rb_frame_this_func();
+  VALUE sites = rb_attr_get(module, id_sites);
+  VALUE site = NIL_P(sites) ? Qnil : rb_hash_aref(sites, ID2SYM(method));
+  if (NIL_P(site))
+    rb_raise( rb_eNameError, "no YCP symbol for method '%s'", rb_id2name(method) );
+
+  call_site *res;
+  Data_Get_Struct(site, call_site, res);
+  resolve_call_site(*res);
+  return res;
+}
+
+/*
+ * Imported YCP function, the caller is the nearest ruby frame
+ */
+static VALUE
+imported_function( int argc, VALUE *argv, VALUE self )
+{
+  call_site *site = imported_call_site(self);
+  std::string file;
+  int line;
+  if (y2ruby_caller_location(0, file, line))
+  {
+    YaST::ee.setFilename(file);
+    YaST::ee.setLinenumber(line);
+  }
+  return call_site_invoke(*site, argc, argv);
+}
+
+static VALUE
+imported_variable_get( VALUE self )
+{
+  return call_site_invoke(*imported_call_site(self), 0, NULL);
+}
+
+static VALUE
+imported_variable_set( VALUE self, VALUE value )
+{
+  return call_site_invoke(*imported_call_site(self), 1, &value);
+}
+
+/*
+ * Document-method: define_imported_methods(module, namespace)
+ * call-seq:
+ *   Yast.define_imported_methods(Yast::Foo, "Foo") -> nil
+ *
+ * Defines native singleton methods of module for the functions and
+ * variables of the YCP namespace, each bound to its own call site.
+ * Used by Yast.import.
+ */
+static VALUE
+ycp_module_define_imported_methods( VALUE self, VALUE module, VALUE namespace_name )
+{
+  static ID id_sites = rb_intern("__call_sites");
+  const char *name = StringValuePtr(namespace_name);
+  Y2Namespace *ns = getNs(name);
+  if (ns == NULL)
+  {
+    rb_raise( rb_eRuntimeError, "error getting namespace '%s'", name );
+  }
+
+  VALUE sites = rb_attr_get(module, id_sites);
+  if (NIL_P(sites))
+  {
+    sites = rb_hash_new();
+    rb_ivar_set(module, id_sites, sites);
+  }
+
+  for (unsigned int i=0; i < ns->symbolCount(); ++i)
+  {
+    SymbolEntryPtr s = ns->symbolEntry(i);
+    const char *symbol_name = s->name();
+    if (*symbol_name == '\0' || !(s->isFunction() || s->isVariable()))
+      continue;
+
+    VALUE site = ycp_module_call_site(self, namespace_name, ID2SYM(rb_intern(symbol_name)));
+    rb_hash_aset(sites, ID2SYM(rb_intern(symbol_name)), site);
+    if (s->isFunction())
     {
-      //set back reference
-      VALUE val = ycpvalue_2_rbvalue(i->second->value());
-      RB_GC_GUARD(val);
-      rb_funcall(argv[i->first], rb_intern("value="), 1, val);
+      rb_define_singleton_method(module, symbol_name, RUBY_METHOD_FUNC(imported_function), -1);
     }
-    return ycpvalue_2_rbvalue(res);
+    else
+    {
+      std::string setter = std::string(symbol_name) + "=";
+      rb_hash_aset(sites, ID2SYM(rb_intern(setter.c_str())), site);
+      rb_define_singleton_method(module, symbol_name, RUBY_METHOD_FUNC(imported_variable_get), 0);
+      rb_define_singleton_method(module, setter.c_str(), RUBY_METHOD_FUNC(imported_variable_set), 1);
+    }
+  }
+  return Qnil;
+}
+
+/*
+ * One call of Yast.call_batch
+ */
+struct batch_call
+{
+  call_site *site;
+  VALUE args;
+  VALUE file;
+  int line;
+};
+
+static VALUE
+batch_call_invoke( VALUE data )
+{
+  batch_call *call = (batch_call *) data;
+  resolve_call_site(*call->site);
+  if (!call_site_is_variable(*call->site))
+  {
+    YaST::ee.setFilename(RSTRING_PTR(call->file));
+    YaST::ee.setLinenumber(call->line);
   }
+  // a copy, ruby code run by the call cannot move the arguments
+  VALUE args = rb_ary_dup(call->args);
+  VALUE res = call_site_invoke(*call->site, RARRAY_LEN(args), RARRAY_PTR(args));
+  RB_GC_GUARD(args);
+  return res;
 }
 
+/*
+ * batch_invoke
+ *
+ * Calls the Yast::CallSite with the given arguments, returns the result
+ * or the raised StandardError
+ */
+static VALUE
+batch_invoke( VALUE site_object, VALUE args, VALUE file, int line )
+{
+  Check_Type(args, T_ARRAY);
+  call_site *site;
+  Data_Get_Struct(site_object, call_site, site);
+  batch_call call = { site, args, file, line };
+  int state = 0;
+  VALUE res = rb_protect(batch_call_invoke, (VALUE) &call, &state);
+  if (state)
+  {
+    res = rb_errinfo();
+    // e.g. Interrupt or throw is not an error of the call
+    if (!rb_obj_is_kind_of(res, rb_eStandardError))
+      rb_jump_tag(state);
+    rb_set_errinfo(Qnil);
+  }
+  return res;
+}
+
+/*
+ * Document-method: call_batch
+ * call-seq:
+ *   Yast.call_batch([["Namespace", :function, *args], ...]) -> Array
+ *   Yast.call_batch("Namespace", :function, [args, ...]) -> Array
+ *
+ * Calls many YCP functions (or reads and sets variables) in one call
+ * from ruby. Each function is looked up only once per batch. The second
+ * form calls one function with each of the argument lists.
+ *
+ * Returns the results in the order of the calls; a call raising
+ * a StandardError has the exception as its result and the batch goes on.
+ */
+static VALUE
+ycp_module_call_batch( int argc, VALUE *argv, VALUE self )
+{
+  if (argc != 1 && argc != 3)
+    rb_raise( rb_eArgError, "wrong number of arguments (%d for 1 or 3)", argc );
+
+  // the calls can raise, so nothing here needs a destructor: the location
+  // is a ruby string and the sites are Yast::CallSite objects
+  VALUE file;
+  int line = 0;
+  {
+    std::string location;
+    y2ruby_caller_location(0, location, line);
+    file = rb_str_new(location.data(), location.size());
+  }
+
+  VALUE calls = argc == 1 ? argv[0] : argv[2];
+  Check_Type(calls, T_ARRAY);
+  VALUE res = rb_ary_new2(RARRAY_LEN(calls));
+
+  if (argc == 3)
+  {
+    VALUE site = ycp_module_call_site(self, argv[0], argv[1]);
+    for (long i = 0; i < RARRAY_LEN(calls); ++i)
+      rb_ary_push(res, batch_invoke(site, RARRAY_AREF(calls, i), file, line));
+    RB_GC_GUARD(site);
+    RB_GC_GUARD(file);
+    return res;
+  }
+
+  // "Namespace::symbol" => Yast::CallSite
+  VALUE sites = rb_hash_new();
+  for (long i = 0; i < RARRAY_LEN(calls); ++i)
+  {
+    VALUE call = RARRAY_AREF(calls, i);
+    Check_Type(call, T_ARRAY);
+    if (RARRAY_LEN(call) < 2)
+      rb_raise( rb_eArgError, "call %ld has no namespace and symbol", i );
+
+    VALUE namespace_name = RARRAY_AREF(call, 0);
+    VALUE symbol = RARRAY_AREF(call, 1);
+    VALUE key = rb_sprintf("%" PRIsVALUE "::%" PRIsVALUE, namespace_name, symbol);
+    VALUE site = rb_hash_lookup(sites, key);
+    if (NIL_P(site))
+    {
+      site = ycp_module_call_site(self, namespace_name, symbol);
+      rb_hash_aset(sites, key, site);
+    }
+
+    VALUE args = rb_ary_subseq(call, 2, RARRAY_LEN(call) - 2);
+    rb_ary_push(res, batch_invoke(site, args, file, line));
+  }
+  RB_GC_GUARD(sites);
+  RB_GC_GUARD(file);
+  return res;
+}
 
 /*--------------------------------------------
  *
@@ -310,6 +894,9 @@ static VALUE add_module_path( VALUE self, VALUE path )
 {
   y2debug ("add module path %s", RSTRING_PTR(path));
   YCPPathSearch::addPath (YCPPathSearch::Module, RSTRING_PTR(path));
+  y2ruby_search_paths_changed();
+  // a name can be found in another module now
+  ++namespace_generation;
   return Qnil;
 }
 
@@ -322,6 +909,8 @@ add_include_path( VALUE self, VALUE path )
 {
   y2debug ("add include path %s", RSTRING_PTR(path));
   YCPPathSearch::addPath (YCPPathSearch::Include, RSTRING_PTR(path));
+  y2ruby_search_paths_changed();
+  ++namespace_generation;
   return Qnil;
 }
 
@@ -349,6 +938,66 @@ static VALUE byteblock_to_s(VALUE self)
 
 }
 
+static YCPByteblock *byteblock_get(VALUE self)
+{
+  YCPByteblock *bb;
+  Data_Get_Struct(self, YCPByteblock, bb);
+  if (!bb)
+    rb_raise(rb_eRuntimeError, "Byteblock is empty");
+  return bb;
+}
+
+static VALUE byteblock_alloc(VALUE klass)
+{
+  return Data_Wrap_Struct(klass, 0, rb_bb_free, 0);
+}
+
+/*
+ * Document-method: Yast::Byteblock#initialize
+ * call-seq:
+ *   Byteblock.new(data)
+ *
+ * Creates byteblock with the bytes of the given string. The bytes are
+ * copied once, directly to the byteblock.
+ */
+static VALUE byteblock_initialize(VALUE self, VALUE data)
+{
+  StringValue(data);
+  // strings from to_binary point into the payload, it cannot be replaced
+  if (DATA_PTR(self) != NULL)
+    rb_raise(rb_eRuntimeError, "Byteblock is already initialized");
+  DATA_PTR(self) = new YCPByteblock((const unsigned char *) RSTRING_PTR(data), RSTRING_LEN(data));
+  return self;
+}
+
+/*
+ * Document-method: Yast::Byteblock#to_binary
+ *
+ * Returns the bytes as frozen binary (ASCII-8BIT) string. The string shares
+ * the memory of the byteblock, nothing is copied, so it is cheap even for
+ * big files. Use StringIO.new(bb.to_binary) to read it like a file.
+ */
+static VALUE byteblock_to_binary(VALUE self)
+{
+  static ID id_byteblock = rb_intern("__byteblock");
+  YCPByteblock *bb = byteblock_get(self);
+
+  VALUE res = rb_str_new_static((const char *) (*bb)->value(), (*bb)->size());
+  // the string does not own the bytes, keep the byteblock alive with it
+  rb_ivar_set(res, id_byteblock, self);
+  return rb_obj_freeze(res);
+}
+
+/*
+ * Document-method: Yast::Byteblock#size
+ *
+ * Returns the number of bytes
+ */
+static VALUE byteblock_size(VALUE self)
+{
+  return LONG2NUM((*byteblock_get(self))->size());
+}
+
 static VALUE ref_call( int argc, VALUE *argv, VALUE self )
 {
   SymbolEntry *se;
@@ -359,14 +1008,18 @@ static VALUE ref_call( int argc, VALUE *argv, VALUE self )
     // add the parameters
     for (int i=0; i < argc; i++)
     {
-      YCPValue v = rbvalue_2_ycpvalue(argv[i]);
+      constTypePtr wanted = call->wantedParameterType();
+      bool matches;
+      YCPValue v = rbvalue_2_ycpvalue_typed(argv[i], wanted, matches);
+      if (!matches)
+        y2debug("Parameter %d of %s does not match its declared type %s", i+1, se->name(), wanted->toString().c_str());
       call->appendParameter (v);
     }
     call->finishParameters ();
 
     YCPValue res = call->evaluateCall ();
     delete call;
-    return ycpvalue_2_rbvalue(res);
+    return ycpvalue_2_rbvalue_result(res);
   }
   else
   {
@@ -380,11 +1033,63 @@ static VALUE code_call( int argc, VALUE *argv, VALUE self )
   YCPCode *yc;
   Data_Get_Struct(self, YCPCode, yc);
   if (yc)
-    return ycpvalue_2_rbvalue((*yc)->evaluate());
+    return ycpvalue_2_rbvalue_result((*yc)->evaluate());
   else
     rb_raise(rb_eRuntimeError, "YCode is empty");
 }
 
+/*
+ * Lazy proxies of big YCP lists and maps, see Yast.lazy_conversion
+ * and yast/lazy.rb for the ruby part
+ */
+static YCPValue lazy_ycpvalue( VALUE self )
+{
+  YCPValue *value;
+  Data_Get_Struct(self, YCPValue, value);
+  return *value;
+}
+
+static VALUE lazy_list_size( VALUE self )
+{
+  return INT2NUM(lazy_ycpvalue(self)->asList()->size());
+}
+
+static VALUE lazy_list_value( VALUE self, VALUE index )
+{
+  YCPList list = lazy_ycpvalue(self)->asList();
+  int i = NUM2INT(index);
+  if (i < 0 || i >= list.size())
+    return Qnil;
+
+  return ycpvalue_2_rbvalue_lazy(list.value(i));
+}
+
+static VALUE lazy_map_size( VALUE self )
+{
+  return INT2NUM(lazy_ycpvalue(self)->asMap()->size());
+}
+
+static VALUE lazy_map_has_key( VALUE self, VALUE key )
+{
+  YCPMap map = lazy_ycpvalue(self)->asMap();
+  return map->haveKey(rbvalue_2_ycpvalue(key)) ? Qtrue : Qfalse;
+}
+
+static VALUE lazy_map_value( VALUE self, VALUE key )
+{
+  YCPMap map = lazy_ycpvalue(self)->asMap();
+  YCPValue ykey = rbvalue_2_ycpvalue(key);
+  if (!map->haveKey(ykey))
+    return Qnil;
+
+  return ycpvalue_2_rbvalue_lazy(map->value(ykey));
+}
+
+static VALUE lazy_entries( VALUE self )
+{
+  return ycpvalue_2_rbvalue_shallow(lazy_ycpvalue(self));
+}
+
 /*
  * Document-method: ui_component
  *
@@ -500,6 +1205,9 @@ extern "C"
     rb_define_singleton_method( rb_mYast, "find_include_file", RUBY_METHOD_FUNC(ycp_find_include_file), 1);
 
     rb_define_singleton_method( rb_mYast, "call_yast_function", RUBY_METHOD_FUNC(ycp_module_call_ycp_function), -1);
+    rb_define_singleton_method( rb_mYast, "call_site", RUBY_METHOD_FUNC(ycp_module_call_site), 2);
+    rb_define_singleton_method( rb_mYast, "call_batch", RUBY_METHOD_FUNC(ycp_module_call_batch), -1);
+    rb_define_singleton_method( rb_mYast, "define_imported_methods", RUBY_METHOD_FUNC(ycp_module_define_imported_methods), 2);
 
     rb_define_singleton_method( rb_mYast, "symbols", RUBY_METHOD_FUNC(ycp_module_symbols), 1);
     rb_define_singleton_method( rb_mYast, "add_module_path", RUBY_METHOD_FUNC(add_module_path), 1);
@@ -514,6 +1222,11 @@ extern "C"
     rb_define_singleton_method( rb_mYast, "ui_component=", RUBY_METHOD_FUNC(ui_set_component), 1);
     rb_define_singleton_method( rb_mYast, "ui_finalizer",     RUBY_METHOD_FUNC(ui_finalizer), 0);
 
+    // resolved YCP symbols
+    rb_cCallSite = rb_define_class_under(rb_mYast, "CallSite", rb_cObject);
+    rb_undef_alloc_func(rb_cCallSite);
+    rb_define_method(rb_cCallSite, "call", RUBY_METHOD_FUNC(call_site_call), -1);
+
     // Y2 references
     rb_cYReference = rb_define_class_under(rb_mYast, "YReference", rb_cObject);
     rb_define_method(rb_cYReference, "call", RUBY_METHOD_FUNC(ref_call), -1);
@@ -524,6 +1237,21 @@ extern "C"
 
     //Byteblock
     rb_cByteblock = rb_define_class_under(rb_mYast, "Byteblock", rb_cObject);
+    rb_define_alloc_func(rb_cByteblock, byteblock_alloc);
+    rb_define_method(rb_cByteblock, "initialize", RUBY_METHOD_FUNC(byteblock_initialize), 1);
     rb_define_method(rb_cByteblock, "to_s", RUBY_METHOD_FUNC(byteblock_to_s), 0);
+    rb_define_method(rb_cByteblock, "to_binary", RUBY_METHOD_FUNC(byteblock_to_binary), 0);
+    rb_define_method(rb_cByteblock, "size", RUBY_METHOD_FUNC(byteblock_size), 0);
+
+    // Lazy proxies, based on BasicObject to forward as much as possible
+    rb_cLazyList = rb_define_class_under(rb_mYast, "LazyList", rb_cBasicObject);
+    rb_define_private_method(rb_cLazyList, "lazy_size", RUBY_METHOD_FUNC(lazy_list_size), 0);
+    rb_define_private_method(rb_cLazyList, "lazy_value", RUBY_METHOD_FUNC(lazy_list_value), 1);
+    rb_define_private_method(rb_cLazyList, "lazy_entries", RUBY_METHOD_FUNC(lazy_entries), 0);
+    rb_cLazyMap = rb_define_class_under(rb_mYast, "LazyMap", rb_cBasicObject);
+    rb_define_private_method(rb_cLazyMap, "lazy_size", RUBY_METHOD_FUNC(lazy_map_size), 0);
+    rb_define_private_method(rb_cLazyMap, "lazy_key?", RUBY_METHOD_FUNC(lazy_map_has_key), 1);
+    rb_define_private_method(rb_cLazyMap, "lazy_value", RUBY_METHOD_FUNC(lazy_map_value), 1);
+    rb_define_private_method(rb_cLazyMap, "lazy_entries", RUBY_METHOD_FUNC(lazy_entries), 0);
   }
 }
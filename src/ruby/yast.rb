@@ -34,6 +34,7 @@ require "yast/exportable"
 require "yast/external"
 require "yast/fun_ref"
 require "yast/i18n"
+require "yast/lazy"
 require "yast/logger"
 require "yast/y2logger"
 require "yast/module"
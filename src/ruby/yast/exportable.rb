@@ -24,6 +24,38 @@ module Yast
       @__published_variables ||= {}
     end
 
+    # Compact description of the exports read by the component system
+    # when the module is imported: two frozen lists, of the functions and
+    # of the variables, with a [name, type, private] triple for each
+    def export_table
+      @__export_table ||= [published_functions, published_variables].map do |exports|
+        exports.map { |name, data| [name, data.type, data.private?].freeze }.freeze
+      end.freeze
+    end
+
+    # Published variables which still use the accessors generated by {#publish}.
+    # The component system reads and writes their instance variables directly.
+    def published_accessors
+      @__published_accessors ||= {}
+    end
+
+    # Forgets the generated accessor of a published variable when the reader
+    # or writer gets redefined
+    def method_added(name)
+      super
+      published_accessors.delete(name.to_s.chomp("=").to_sym)
+    end
+
+    # Forgets the generated accessors overridden by the prepended modules,
+    # they come before the class in its ancestors
+    def prepend(*modules)
+      super
+      published_accessors.delete_if do |name, _|
+        instance_method(name).owner != self || instance_method(:"#{name}=").owner != self
+      end
+      self
+    end
+
     # Publishes function or variable to component system
     # @param (Hash) options specified parameters
     # @option options [String] :type specified Yast type that allows communication with type languages
@@ -40,12 +72,14 @@ module Yast
       type = type.gsub(/map([^<]|$)/, 'map<any,any>\\1')
       type = type.gsub(/list([^<]|$)/, 'list<any>\\1')
       options[:type] = type
+      @__export_table = nil
       if options[:function]
         published_functions[options[:function]] = ExportData.new options
       elsif options[:variable]
         published_variables[options[:variable]] = ExportData.new options
         if !options[:private] || ENV["Y2ALLGLOBAL"]
           attr_accessor :"#{options[:variable]}"
+          published_accessors[options[:variable]] = true
         end
       else
         raise "Missing publish kind"
@@ -0,0 +1,111 @@
+require "yastx"
+
+module Yast
+  # Common part of {LazyList} and {LazyMap}.
+  #
+  # Items are converted from YCP on first access and remembered, so changes
+  # done to them are kept. Any method not handled lazily converts the whole
+  # collection (big nested items stay lazy) and is forwarded to the result,
+  # so the proxy can be used as Array or Hash.
+  #
+  # @note `Array === proxy` and `case proxy when ::Array` do not see through
+  #   the proxy, use {Yast.lazy_conversion} only where it does not matter.
+  # @private
+  module LazyProxy
+    # @return [Array, Hash] fully converted collection
+    def __getobj__
+      return @__materialized if @__materialized
+
+      entries = lazy_entries
+      @__items.each { |key, value| entries[key] = value } if @__items
+      @__items = nil
+      @__materialized = entries
+    end
+
+    def ==(other)
+      __getobj__ == other
+    end
+
+    def size
+      materialized? ? @__materialized.size : lazy_size
+    end
+    alias_method :length, :size
+
+    def empty?
+      size == 0
+    end
+
+    def method_missing(name, *args, &block)
+      __getobj__.__send__(name, *args, &block)
+    end
+
+    private
+
+    def materialized?
+      !@__materialized.nil?
+    end
+
+    # converts item only once, so it is always the same object
+    def lazy_item(key)
+      @__items ||= {}
+      return @__items[key] if @__items.key?(key)
+
+      @__items[key] = yield
+    end
+  end
+
+  # Proxy of a big YCP list, see {LazyProxy}
+  class LazyList < BasicObject
+    include LazyProxy
+
+    def [](*args)
+      index = args.first
+      if materialized? || args.size != 1 || !(::Integer === index)
+        return method_missing(:[], *args)
+      end
+
+      index += size if index < 0
+      return nil if index < 0 || index >= size
+
+      lazy_item(index) { lazy_value(index) }
+    end
+    alias_method :at, :[]
+
+    def first(*args)
+      args.empty? ? self[0] : method_missing(:first, *args)
+    end
+
+    def last(*args)
+      args.empty? ? self[-1] : method_missing(:last, *args)
+    end
+  end
+
+  # Proxy of a big YCP map, see {LazyProxy}
+  class LazyMap < BasicObject
+    include LazyProxy
+
+    def [](key)
+      return @__materialized[key] if materialized?
+      return nil unless key?(key)
+
+      lazy_item(key) { lazy_value(key) }
+    end
+
+    def fetch(key, *args, &block)
+      return method_missing(:fetch, key, *args, &block) if materialized? || !key?(key)
+
+      self[key]
+    end
+
+    def key?(key)
+      return @__materialized.key?(key) if materialized?
+
+      (@__items && @__items.key?(key)) || lazy_key?(key)
+    rescue ::RuntimeError # key not convertible to YCP
+      __getobj__.key?(key)
+    end
+    alias_method :has_key?, :key?
+    alias_method :include?, :key?
+    alias_method :member?, :key?
+  end
+end
@@ -104,12 +104,5 @@ module Yast
     def self.UnmountAgent(path)
       call_builtin_wrapper("UnmountAgent", path)
     end
-
-    # @private wrapper to C bindings
-    def self.call_builtin_wrapper(*args)
-      # caller[0] is one of the functions above
-      caller[1].match BACKTRACE_REGEXP
-      call_builtin(Regexp.last_match(1), Regexp.last_match(2).to_i, *args)
-    end
   end
 end
@@ -83,6 +83,12 @@ module Yast
       Yast::Term.new value, *Yast.deep_copy(params)
     end
 
+    # Freezes also the params, so a frozen term cannot be modified
+    def freeze
+      @params.freeze
+      super
+    end
+
     def to_s
       "`#{value} (#{params.map { |p| Yast::Builtins.inside_tostring p }.join ", "})"
     end
@@ -2,8 +2,6 @@ require "yast/builtinx"
 require "yast/builtins"
 require "yast/ops"
 
-# @private we need it as clients is called in global contenxt
-GLOBAL_WFM_CONTEXT = proc {}
 module Yast
   # Wrapper class for WFM component in Yast
   # See yast documentation for WFM
@@ -174,19 +172,31 @@ module Yast
       call_builtin_wrapper("CallFunction", client, *args)
     end
 
-    # @private wrapper to C code
-    def self.call_builtin_wrapper(*args)
-      # caller[0] is one of the functions above
-      caller[1].match BACKTRACE_REGEXP
-      call_builtin(Regexp.last_match(1), Regexp.last_match(2).to_i, *args)
+    # @private compiled clients, path => [file stamp, instruction sequence]
+    def self.compiled_clients
+      @compiled_clients ||= {}
+    end
+
+    # @private compiles the client code and remembers it for the next runs
+    def self.compile_client(client, code, stamp)
+      iseq = RubyVM::InstructionSequence.compile(code, client, client, 1)
+      compiled_clients[client] = [stamp, iseq]
+      iseq
     end
 
     # @private wrapper to run client in ruby
     def self.run_client(client)
       Builtins.y2milestone "Call client %1", client
-      code = File.read client
+      # clients run repeatedly are compiled only once, until they change;
+      # the size and inode catch rewrites within the mtime resolution
+      stat = File.stat client
+      stamp = [stat.mtime, stat.size, stat.ino]
+      compiled = compiled_clients[client]
+      code = File.read client unless compiled && compiled.first == stamp
       begin
-        result = eval(code, GLOBAL_WFM_CONTEXT.binding, client)
+        iseq = code ? compile_client(client, code, stamp) : compiled.last
+        # runs in the global context like a loaded file
+        result = iseq.eval
 
         allowed_types = Ops::TYPES_MAP.values.flatten
         allowed_types.delete(::Object) # remove generic type for any
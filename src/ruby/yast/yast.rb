@@ -7,9 +7,6 @@ module Yast
   class YReference; end
   class Path; end
 
-  # @private used to extract place from backtrace
-  BACKTRACE_REGEXP = /^(.*):(\d+):in `.*'$/
-
   # shortcut to construct new Yast term
   # @see Yast::Term
   def term(*args)
@@ -65,6 +62,8 @@ module Yast
       options[:full] ? object.clone : object
     when Yast::FunRef, Yast::ArgRef, Yast::External, Yast::YReference, Yast::YCode # contains only reference somewhere
       object
+    when Yast::LazyList, Yast::LazyMap
+      deep_copy(object.__getobj__, options)
     when ::Hash
       object.each_with_object({}) do |kv, acc|
         acc[deep_copy(kv[0])] = deep_copy(kv[1])
@@ -85,6 +84,80 @@ module Yast
   end
   alias_method :copy_arg, :deep_copy
 
+  # Converts big lists and maps returned from the component system during
+  # the block lazily. They are returned as {Yast::LazyList} and
+  # {Yast::LazyMap} proxies, which convert an item only when it is accessed.
+  # It makes reading a huge result (e.g. hardware probing) cheap
+  # when only a few items are used. Only the results of the calls are lazy,
+  # arguments of callbacks and values written back to {ArgRef} are not.
+  #
+  # @note the proxies act like Array and Hash, but `Array === proxy` is false
+  # @example read only the first disk
+  #   disk = Yast.lazy_conversion { SCR.Read(path(".probe.disk")).first }
+  def self.lazy_conversion(&block)
+    with_conversion_flag(:@__lazy_conversion, &block)
+  end
+
+  # Keeps values referenced many times shared when converting them between
+  # Ruby and the component system during the block, in both directions.
+  # E.g. a default map referenced from every item of a list is converted
+  # only once and the result is referenced from all the items. Cyclic
+  # Ruby structures are reported by a RuntimeError.
+  #
+  # @note modifying a shared converted value is visible from all places
+  #   referencing it
+  # @example pass the same defaults to many items
+  #   defaults = { "size" => 0, "used" => false }
+  #   Yast.shared_conversion { Storage.SetDevices(devices.map { defaults }) }
+  def self.shared_conversion(&block)
+    with_conversion_flag(:@__shared_conversion, &block)
+  end
+
+  # Converts map keys coming from the component system during the block
+  # to frozen strings shared by all results, so keys repeated in every item
+  # of a big list of maps are allocated only once.
+  #
+  # @param values [Boolean] share also short string values; they are
+  #   frozen then, so they must not be modified in place
+  # @example read the hardware with shared keys
+  #   cards = Yast.interned_conversion { SCR.Read(path(".probe.netcard")) }
+  def self.interned_conversion(values: false, &block)
+    with_conversion_flag(:@__interned_conversion, values ? :all : :keys, &block)
+  end
+
+  # Converts deeply frozen Arrays, Hashes and Terms passed to the component
+  # system during the block only once. Later calls passing the same object
+  # reuse its converted value, as long as the object is alive. Objects with
+  # any unfrozen part are converted every time.
+  #
+  # @example pass a constant term repeatedly
+  #   BUTTONS = Yast::Term.new(:HBox, Yast::Term.new(:PushButton, "OK".freeze).freeze).freeze
+  #   Yast.cached_conversion { items.each { |i| UI.ReplaceWidget(Id(i), BUTTONS) } }
+  def self.cached_conversion(&block)
+    with_conversion_flag(:@__cached_conversion, &block)
+  end
+
+  # Returns the same deeply frozen value from repeated reads of an imported
+  # YCP variable during the block as long as the variable is not changed,
+  # so big module state is not converted again on every access. Reads
+  # outside the block, and inside {lazy_conversion}, return fresh copies.
+  #
+  # @note the returned values are frozen, modify a copy
+  # @example poll a big module map
+  #   Yast.cached_variables { Foo.devices.keys }
+  def self.cached_variables(&block)
+    with_conversion_flag(:@__cached_variables, &block)
+  end
+
+  # @private sets conversion flag read by the native converters
+  def self.with_conversion_flag(name, value = true)
+    old = instance_variable_get(name)
+    instance_variable_set(name, value)
+    yield
+  ensure
+    instance_variable_set(name, old)
+  end
+
   # includes module from include directory.
   # given include must satisfied few restrictions.
   # 1) file must contain module enclosed in Yast namespace
@@ -168,6 +241,10 @@ module Yast
     end
 
     import_pure(mname)
+    # a Ruby module imported from its cached manifest is required on its
+    # first use, but Ruby code needs its constant right away
+    lazy_path = @__lazy_modules && @__lazy_modules.delete(mname)
+    require lazy_path if lazy_path
 
     # do not create wrapper if module is in ruby and define itself object
     if base.constants.include?(modules.last.to_sym) &&
@@ -180,27 +257,8 @@ module Yast
         else
           ::Module.new
         end
-    symbols(mname).each do |sname, stype|
-      next if sname.empty?
-      if (stype == :function)
-        m.module_eval <<-"END"
-          def self.#{sname}(*args)
-            caller[0].match BACKTRACE_REGEXP
-            return Yast::call_yast_function("#{mname}", :#{sname}, $1, $2.to_i, *args)
-          end
-        END
-      end
-      if stype == :variable
-        m.module_eval <<-"END"
-          def self.#{sname}
-            return Yast::call_yast_function("#{mname}", :#{sname})
-          end
-          def self.#{sname}= (value)
-            return Yast::call_yast_function("#{mname}", :#{sname}, value)
-          end
-        END
-      end
-    end
+    # native methods bound to call sites of the functions and variables
+    define_imported_methods(m, mname)
 
     base.const_set(modules.last, m) unless base.constants.include?(modules.last.to_sym)
   end
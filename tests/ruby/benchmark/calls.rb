@@ -0,0 +1,38 @@
+#! /usr/bin/env ruby
+#
+# Benchmark of calling functions and reading variables of YCP and Ruby
+# modules from Ruby.
+#
+# Run after building: ruby tests/ruby/benchmark/calls.rb
+
+require_relative "../test_helper"
+
+require "benchmark"
+require "yast"
+
+CALLS = 100_000
+
+Yast.import "ExampleTestModule"
+
+is_xen = Yast.call_site("ExampleTestModule", :is_xen)
+echo_string = Yast.call_site("TypedTestModule", :echo_string)
+echo_list = Yast.call_site("TypedTestModule", :echo_list)
+plain = Yast.call_site("VariableTestModule", :plain)
+custom = Yast.call_site("VariableTestModule", :custom)
+list = Array.new(100) { |i| "item #{i}" }
+
+Benchmark.bm(28) do |x|
+  x.report("YCP function, wrapper") { CALLS.times { Yast::ExampleTestModule.is_xen } }
+  x.report("YCP function, call site") { CALLS.times { is_xen.call(__FILE__, __LINE__) } }
+  x.report("YCP function, call_batch") do
+    Yast.call_batch("ExampleTestModule", :is_xen, Array.new(CALLS) { [] })
+  end
+  x.report("YCP variable") { CALLS.times { Yast::ExampleTestModule.example_string } }
+  x.report("YCP variable, cached") do
+    Yast.cached_variables { CALLS.times { Yast::ExampleTestModule.example_string } }
+  end
+  x.report("Ruby function") { CALLS.times { echo_string.call(__FILE__, __LINE__, "value") } }
+  x.report("Ruby function, typed list") { (CALLS / 10).times { echo_list.call(__FILE__, __LINE__, list) } }
+  x.report("Ruby variable, plain") { CALLS.times { plain.call } }
+  x.report("Ruby variable, custom") { CALLS.times { custom.call } }
+end
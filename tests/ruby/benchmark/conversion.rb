@@ -0,0 +1,59 @@
+#! /usr/bin/env ruby
+#
+# Benchmark of converting values between Ruby and the component system.
+# Each value passes both directions through the echo client.
+#
+# Run after building: ruby tests/ruby/benchmark/conversion.rb
+
+require_relative "../test_helper"
+
+require "benchmark"
+require "yast"
+
+ROUNDS = 20
+
+def echo(value)
+  Yast::WFM.CallFunction("echo_client", [value])
+end
+
+def allocated_objects
+  GC.start
+  before = GC.stat[:total_allocated_objects]
+  yield
+  GC.stat[:total_allocated_objects] - before
+end
+
+# hwinfo like result, the same keys repeat in every item
+disks = Array.new(5_000) do |i|
+  {
+    "device" => "/dev/sd#{i}", "name" => "Disk #{i}", "size" => i * 512,
+    "bus" => "SCSI", "driver" => "sd", "rotational" => true
+  }
+end
+paths = Array.new(10_000) { |i| Yast::Path.new(".target.item#{i}") }
+terms = Array.new(10_000) { |i| Yast::Term.new(:Item, Yast::Term.new(:id, i), "item #{i}") }
+nested = (1..10_000).reduce([]) { |a, _| [a] }
+defaults = { "fs" => "ext4", "options" => ["noatime", "acl"], "mount" => true }
+shared = Array.new(10_000) { defaults }
+frozen = Yast::Term.new(:VBox, *Array.new(1_000) { |i| Yast::Term.new(:Label, "label #{i}".freeze).freeze }).freeze
+bytes = Yast::Byteblock.new("x" * 10_000_000)
+
+Benchmark.bm(28) do |x|
+  x.report("list of maps") { ROUNDS.times { echo(disks) } }
+  x.report("list of maps, lazy, 1 item") { ROUNDS.times { Yast.lazy_conversion { echo(disks)[42] } } }
+  x.report("list of maps, interned keys") { ROUNDS.times { Yast.interned_conversion { echo(disks) } } }
+  x.report("paths") { ROUNDS.times { echo(paths) } }
+  x.report("terms") { ROUNDS.times { echo(terms) } }
+  x.report("nested 10000 levels") { ROUNDS.times { echo(nested) } }
+  x.report("shared subtrees") { ROUNDS.times { echo(shared) } }
+  x.report("shared subtrees, shared") { ROUNDS.times { Yast.shared_conversion { echo(shared) } } }
+  x.report("frozen term") { (ROUNDS * 10).times { echo(frozen) } }
+  x.report("frozen term, cached") { Yast.cached_conversion { (ROUNDS * 10).times { echo(frozen) } } }
+  x.report("byteblock to_binary") { ROUNDS.times { echo(bytes).to_binary } }
+end
+
+puts
+puts "Allocated objects converting the list of maps:"
+puts "  plain:         #{allocated_objects { echo(disks) }}"
+puts "  interned keys: #{allocated_objects { Yast.interned_conversion { echo(disks) } }}"
+puts "  interned all:  #{allocated_objects { Yast.interned_conversion(values: true) { echo(disks) } }}"
@@ -0,0 +1,38 @@
+#! /usr/bin/env ruby
+#
+# Benchmark of finding and loading modules, includes and clients.
+#
+# Run after building: ruby tests/ruby/benchmark/loading.rb
+
+require_relative "../test_helper"
+
+require "benchmark"
+require "tmpdir"
+require "yast"
+
+LOOKUPS = 100_000
+PROCESSES = 20
+
+# a new process for each import, the component remembers its namespaces
+def import_in_process(env = {})
+  helper = $LOADED_FEATURES.grep(/test_helper/).first
+  script = "load '#{helper}'; require 'yast'; Yast.import 'RefTestModule'"
+  system(env, "ruby", "-e", script) || abort("import failed")
+end
+
+Dir.mktmpdir do |dir|
+  client = File.join(dir, "bench_client.rb")
+  File.write(client, "Yast::Term.new(:Label, 'client').params.size")
+  File.write(File.join(dir, "bench_include.rb"), "")
+  Yast.add_include_path(dir)
+
+  Benchmark.bm(28) do |x|
+    x.report("import") { PROCESSES.times { import_in_process } }
+    x.report("import, manifest") do
+      PROCESSES.times { import_in_process("Y2RUBY_MANIFEST_DIR" => dir) }
+    end
+    x.report("import underscored file") { Yast.import "DelimTestModule" }
+    x.report("find include") { LOOKUPS.times { Yast.find_include_file("bench_include.rb") } }
+    x.report("run client") { (LOOKUPS / 10).times { Yast::WFM.run_client(client) } }
+  end
+end
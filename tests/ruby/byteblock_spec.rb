@@ -0,0 +1,57 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+require "tmpdir"
+
+describe Yast::Byteblock do
+  around do |example|
+    Dir.mktmpdir do |dir|
+      @file = File.join(dir, "data.bin")
+      example.run
+    end
+  end
+
+  let(:data) { (0..255).map(&:chr).join * 4 }
+
+  def read_byteblock
+    Yast::SCR.Read(Yast::Path.new(".target.byte"), @file)
+  end
+
+  it "returns bytes of the byteblock as frozen binary string" do
+    File.binwrite(@file, data)
+    bytes = read_byteblock.to_binary
+
+    expect(bytes).to eq data.b
+    expect(bytes.encoding).to eq Encoding::ASCII_8BIT
+    expect(bytes).to be_frozen
+  end
+
+  it "keeps the bytes valid after the byteblock is gone" do
+    File.binwrite(@file, data)
+    bytes = read_byteblock.to_binary
+    GC.start
+
+    expect(bytes).to eq data.b
+  end
+
+  it "returns the size" do
+    File.binwrite(@file, data)
+    expect(read_byteblock.size).to eq data.bytesize
+  end
+
+  it "can be created from a string" do
+    Yast::SCR.Write(Yast::Path.new(".target.byte"), @file, Yast::Byteblock.new(data))
+    expect(File.binread(@file)).to eq data.b
+  end
+
+  it "refuses to be initialized again" do
+    File.binwrite(@file, data)
+    byteblock = read_byteblock
+    bytes = byteblock.to_binary
+
+    expect { byteblock.send(:initialize, "other") }.to raise_error(RuntimeError, /already initialized/)
+    expect(bytes).to eq data.b
+  end
+end
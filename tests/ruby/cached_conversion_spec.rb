@@ -0,0 +1,51 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+
+describe "Yast.cached_conversion" do
+  def echo(value)
+    Yast::WFM.CallFunction("echo_client", [value])
+  end
+
+  let(:options) do
+    {
+      "fs"      => "ext4".freeze,
+      "options" => ["noatime".freeze, "acl".freeze].freeze,
+      "size"    => 42
+    }.freeze
+  end
+
+  it "converts a deeply frozen value repeatedly" do
+    Yast.cached_conversion do
+      3.times { expect(echo(options)).to eq options }
+    end
+  end
+
+  it "converts frozen terms" do
+    term = Yast::Term.new(:Label, "text".freeze, :center).freeze
+    Yast.cached_conversion do
+      2.times { expect(echo(term)).to eq term }
+    end
+  end
+
+  it "converts a value with unfrozen parts every time" do
+    list = [["a"].freeze].freeze
+    Yast.cached_conversion do
+      expect(echo(list)).to eq [["a"]]
+      list.first.first << "b"
+      expect(echo(list)).to eq [["ab"]]
+    end
+  end
+
+  it "keeps its helper class private" do
+    Yast.cached_conversion { echo(options) }
+    expect { Yast::FrozenConversion }.to raise_error(NameError)
+  end
+
+  it "restores the default conversion after the block" do
+    expect { Yast.cached_conversion { raise "failed" } }.to raise_error("failed")
+    expect(Yast.instance_variable_get(:@__cached_conversion)).to be_nil
+  end
+end
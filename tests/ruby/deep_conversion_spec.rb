@@ -0,0 +1,81 @@
+#!/usr/bin/env rspec
+# encoding: utf-8
+
+require_relative "test_helper"
+
+require "yast"
+
+describe "conversion of nested values" do
+  def echo(value)
+    Yast::WFM.CallFunction("echo_client", [value])
+  end
+
+  # arrays and hashes alternating, walked without recursion
+  def nested(depth)
+    value = "leaf"
+    depth.times { |i| value = i.even? ? [value] : { "item" => value } }
+    value
+  end
+
+  def nesting_of(value)
+    depth = 0
+    loop do
+      case value
+      when Array then value = value.first
+      when Hash then value = value["item"]
+      else return depth
+      end
+      depth += 1
+    end
+  end
+
+  def random_value(rng, level)
+    case rng.rand(level > 3 ? 7 : 10)
+    when 0 then nil
+    when 1 then rng.rand(1000) - 500
+    when 2 then rng.rand
+    when 3 then "string #{rng.rand(100)}"
+    when 4 then :"symbol#{rng.rand(10)}"
+    when 5 then rng.rand(2) == 0
+    when 6 then Yast::Path.new(".target.dir")
+    when 7 then Array.new(rng.rand(5)) { random_value(rng, level + 1) }
+    when 8 then Hash[Array.new(rng.rand(5)) { [random_key(rng), random_value(rng, level + 1)] }]
+    # Term#== is YCP comparison, keep the params simple
+    else Yast::Term.new(:id, *Array.new(rng.rand(3)) { random_value(rng, 4) })
+    end
+  end
+
+  def random_key(rng)
+    [rng.rand(100), "key#{rng.rand(100)}", :"key#{rng.rand(10)}"].sample(random: rng)
+  end
+
+  it "converts values same as the recursive conversion did" do
+    rng = Random.new(42)
+    100.times do
+      value = random_value(rng, 0)
+      expect(echo(value)).to eq value
+    end
+  end
+
+  it "converts hashes mixing scalar and nested values" do
+    hash = { "a" => 1, "b" => ["c", { "d" => nil }], :e => Yast::Term.new(:id, 2), 3 => 4.5 }
+    expect(echo(hash)).to eq hash
+  end
+
+  it "converts lists of one scalar type" do
+    lists = [[1, 2**40, -3], ["a", "ř"], [1.5, 2.0], [true, false], [:a, :b], [1, "a", nil], []]
+    lists.each { |list| expect(echo(list)).to eq list }
+    expect(echo(["ř"]).first.encoding).to eq Encoding::UTF_8
+  end
+
+  it "converts deeply nested values" do
+    expect(nesting_of(echo(nested(10_000)))).to eq 10_000
+  end
+
+  it "raises RuntimeError for cyclic structures" do
+    list = [1]
+    list << { "self" => list }
+
+    expect { echo(list) }.to raise_error(RuntimeError, /Cyclic/)
+  end
+end
@@ -41,8 +41,55 @@ describe "ExportableTest" do
     expect(MyTest.variable_a).to eq(({ a: 15 }))
   end
 
+  it "tests export table" do
+    expect(MyTest.class.export_table).to eq [
+      [[:test, "string(integer,term)", false]],
+      [[:complex, "map<string,map<list<any>,map<any,any>>>", false],
+       [:variable_a, "map<any,any>", false]]
+    ]
+    expect(MyTest.class.export_table).to be_frozen
+  end
+
   it "tests type full specification" do
     expect(MyTest.class.published_variables[:complex].type)
       .to eq("map<string,map<list<any>,map<any,any>>>")
   end
 end
+
+class MyAccessorClass
+  extend Yast::Exportable
+  publish variable: :plain, type: "string"
+  publish variable: :custom, type: "string"
+  publish variable: :hidden, type: "string", private: true
+
+  def custom
+    "custom"
+  end
+end
+
+describe "Yast::Exportable#published_accessors" do
+  it "contains variables with generated accessors" do
+    expect(MyAccessorClass.published_accessors).to eq(plain: true)
+  end
+
+  it "forgets a variable when its writer is redefined" do
+    klass = Class.new do
+      extend Yast::Exportable
+      publish variable: :value, type: "integer"
+    end
+    klass.send(:define_method, :value=) { |v| @value = v + 1 }
+
+    expect(klass.published_accessors).to be_empty
+  end
+
+  it "forgets a variable when a prepended module overrides its reader" do
+    klass = Class.new do
+      extend Yast::Exportable
+      publish variable: :value, type: "integer"
+      publish variable: :other, type: "integer"
+    end
+    klass.send(:prepend, Module.new { def value; 42; end })
+
+    expect(klass.published_accessors).to eq(other: true)
+  end
+end
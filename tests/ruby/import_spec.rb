@@ -0,0 +1,111 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+
+describe "Yast.import" do
+  before(:all) do
+    Yast.import "ExampleTestModule"
+  end
+
+  it "creates wrappers of module functions" do
+    expect(Yast::ExampleTestModule.arch_short).to eq "ZX Spectrum"
+    expect(Yast::ExampleTestModule.sparc_map).to eq("one" => 1, "two" => 2)
+  end
+
+  it "calls module functions from deep call stacks" do
+    deep_call = ->(depth) { depth.zero? ? Yast::ExampleTestModule.is_xen : deep_call.(depth - 1) }
+    expect(deep_call.(200)).to eq false
+  end
+
+  it "creates accessors of module variables" do
+    expect(Yast::ExampleTestModule.example_string).to eq "x86_64"
+
+    Yast::ExampleTestModule.example_string = "s390"
+    expect(Yast::ExampleTestModule.example_string).to eq "s390"
+    Yast::ExampleTestModule.example_string = "x86_64"
+  end
+
+  it "finds a module in a file with the underscored name" do
+    Yast.import "DelimTestModule"
+    expect(Yast::DelimTestModule.file_name).to eq "delim_test_module"
+  end
+end
+
+describe "Yast.call_site" do
+  it "calls the symbol repeatedly" do
+    site = Yast.call_site("ExampleTestModule", :is_xen)
+    3.times { expect(site.call(__FILE__, __LINE__)).to eq false }
+  end
+
+  it "keeps working after the search paths change" do
+    site = Yast.call_site("ExampleTestModule", :is_xen)
+    expect(site.call(__FILE__, __LINE__)).to eq false
+    Yast.add_module_path(File.join(__dir__, "test_module", "modules"))
+    expect(site.call(__FILE__, __LINE__)).to eq false
+  end
+
+  it "raises NameError on call if the symbol does not exist" do
+    site = Yast.call_site("ExampleTestModule", :not_existing)
+    expect { site.call(__FILE__, __LINE__) }.to raise_error(NameError)
+  end
+
+  it "passes arguments by reference without logging errors" do
+    # the y2log of liby2util, errors are logged with the <3> level
+    log = Process.uid.zero? ? "/var/log/YaST2/y2log" : File.join(Dir.home, ".y2log")
+    site = Yast.call_site("RefTestModule", :touch)
+    logged = File.exist?(log) ? File.size(log) : 0
+
+    expect(site.call(__FILE__, __LINE__, Yast::ArgRef.new("value"))).to eq true
+    errors = File.exist?(log) ? IO.read(log, nil, logged).lines.grep(/ <3> /) : []
+    expect(errors).to be_empty
+  end
+end
+
+describe "Yast.call_batch" do
+  it "returns results of all calls" do
+    calls = [["ExampleTestModule", :arch_short], ["ExampleTestModule", :is_xen]]
+    expect(Yast.call_batch(calls)).to eq ["ZX Spectrum", false]
+  end
+
+  it "calls one function with each argument list" do
+    expect(Yast.call_batch("ExampleTestModule", :is_xen, [[], []])).to eq [false, false]
+  end
+
+  it "returns the error of a failed call and continues" do
+    calls = [["ExampleTestModule", :not_existing], ["ExampleTestModule", :is_xen]]
+    res = Yast.call_batch(calls)
+
+    expect(res.first).to be_a(NameError)
+    expect(res.last).to eq false
+  end
+end
+
+describe "Yast.cached_variables" do
+  before(:all) do
+    Yast.import "ExampleTestModule"
+  end
+
+  it "returns the same frozen value while the variable is unchanged" do
+    Yast.cached_variables do
+      value = Yast::ExampleTestModule.example_string
+      expect(value).to eq "x86_64"
+      expect(value).to be_frozen
+      expect(Yast::ExampleTestModule.example_string).to equal(value)
+    end
+  end
+
+  it "returns the new value after a write" do
+    Yast.cached_variables do
+      Yast::ExampleTestModule.example_string
+      Yast::ExampleTestModule.example_string = "s390"
+      expect(Yast::ExampleTestModule.example_string).to eq "s390"
+    end
+    Yast::ExampleTestModule.example_string = "x86_64"
+  end
+
+  it "returns modifiable copies outside of the block" do
+    expect(Yast::ExampleTestModule.example_string).to_not be_frozen
+  end
+end
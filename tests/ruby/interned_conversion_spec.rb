@@ -0,0 +1,38 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+
+describe "Yast.interned_conversion" do
+  def echo(value)
+    Yast::WFM.CallFunction("echo_client", [value])
+  end
+
+  let(:devices) { Array.new(3) { |i| { "name" => "sda#{i}", "size" => i } } }
+
+  it "shares frozen map keys between the converted maps" do
+    list = Yast.interned_conversion { echo(devices) }
+
+    expect(list).to eq devices
+    expect(list[0].keys.first).to be_frozen
+    expect(list[0].keys.first).to equal(list[2].keys.first)
+  end
+
+  it "does not freeze values by default" do
+    list = Yast.interned_conversion { echo(devices) }
+    expect(list[0]["name"]).to_not be_frozen
+  end
+
+  it "shares short values with values: true" do
+    list = Yast.interned_conversion(values: true) { echo(["disk", "disk"]) }
+
+    expect(list.first).to be_frozen
+    expect(list.first).to equal(list.last)
+  end
+
+  it "restores the default conversion after the block" do
+    expect { Yast.interned_conversion { raise "failed" } }.to raise_error("failed")
+    expect(Yast.instance_variable_get(:@__interned_conversion)).to be_nil
+  end
+end
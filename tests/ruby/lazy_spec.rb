@@ -0,0 +1,57 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+require "tmpdir"
+
+describe "Yast.lazy_conversion" do
+  around do |example|
+    Dir.mktmpdir do |dir|
+      @dir = dir
+      200.times { |i| File.write(File.join(dir, format("file%03d", i)), "") }
+      example.run
+    end
+  end
+
+  def read_dir
+    Yast::SCR.Read(Yast::Path.new(".target.dir"), @dir)
+  end
+
+  it "returns big lists as lazy proxies" do
+    list = Yast.lazy_conversion { read_dir }
+    expect(Yast::LazyList === list).to eq true
+  end
+
+  it "does not change conversion outside of the block" do
+    Yast.lazy_conversion { read_dir }
+    expect(read_dir).to be_a(Array)
+  end
+
+  it "returns same values as eager conversion" do
+    list = Yast.lazy_conversion { read_dir }
+    expected = read_dir
+
+    expect(list.size).to eq expected.size
+    expect(list[10]).to eq expected[10]
+    expect(list.last).to eq expected.last
+    expect(list).to eq expected
+  end
+
+  it "keeps modifications of accessed items" do
+    list = Yast.lazy_conversion { read_dir }
+    list[0] << "_changed"
+    list << "new_item"
+
+    expect(list.to_a.first).to end_with("_changed")
+    expect(list.to_a.last).to eq "new_item"
+  end
+
+  it "passes proxy back to the component system" do
+    list = Yast.lazy_conversion { read_dir }
+    file = File.join(@dir, "list.ycp")
+    Yast::SCR.Write(Yast::Path.new(".target.ycp"), file, list)
+
+    expect(Yast::SCR.Read(Yast::Path.new(".target.ycp"), file)).to eq read_dir - ["list.ycp"]
+  end
+end
@@ -0,0 +1,48 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+require "tmpdir"
+
+describe "Y2RUBY_MANIFEST_DIR" do
+  around do |example|
+    Dir.mktmpdir do |dir|
+      @dir = dir
+      example.run
+    end
+  end
+
+  let(:manifest) { File.join(@dir, "RefTestModule.manifest") }
+
+  # a new process for each import, the component remembers its namespaces
+  def import_and_call
+    # require_relative does not work in -e
+    helper = $LOADED_FEATURES.grep(/test_helper/).first
+    script = <<-EOS
+      load '#{helper}'
+      require 'yast'
+      site = Yast.call_site('RefTestModule', :touch)
+      print site.call('manifest_spec.rb', 1, Yast::ArgRef.new('value'))
+    EOS
+    IO.popen({ "Y2RUBY_MANIFEST_DIR" => @dir }, ["ruby", "-e", script], &:read)
+  end
+
+  it "writes the manifest on the first import" do
+    expect(import_and_call).to eq "true"
+    expect(File.read(manifest)).to include("f 0 touch boolean (string &)")
+  end
+
+  it "imports the module from its manifest again" do
+    2.times { expect(import_and_call).to eq "true" }
+  end
+
+  it "replaces a broken manifest" do
+    import_and_call
+    key = File.readlines(manifest).first
+    File.write(manifest, key + "f 0 touch broken (\n")
+
+    expect(import_and_call).to eq "true"
+    expect(File.read(manifest)).to include("f 0 touch boolean (string &)")
+  end
+end
@@ -0,0 +1,41 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+
+describe "published variables of Ruby modules" do
+  before(:all) do
+    Yast.import "VariableTestModule"
+  end
+
+  # reads and writes the variable through the component system
+  def ycp_variable(name)
+    Yast.call_site("VariableTestModule", name)
+  end
+
+  it "reads and writes a variable with the generated accessors directly" do
+    expect(ycp_variable(:plain).call).to eq "plain"
+
+    ycp_variable(:plain).call("changed")
+    expect(Yast::VariableTestModule.plain).to eq "changed"
+    expect(ycp_variable(:plain).call).to eq "changed"
+  end
+
+  it "uses the custom accessors of a variable" do
+    expect(ycp_variable(:custom).call).to eq "CUSTOM"
+
+    ycp_variable(:custom).call("changed")
+    expect(Yast::VariableTestModule.instance_variable_get(:@custom)).to eq "changed!"
+    expect(ycp_variable(:custom).call).to eq "CHANGED!"
+  end
+
+  it "uses the accessors of a prepended module" do
+    expect(ycp_variable(:prepended).call).to eq "from prepended module"
+  end
+
+  it "uses the accessors of a test double" do
+    allow(Yast::VariableTestModule).to receive(:plain).and_return("double")
+    expect(ycp_variable(:plain).call).to eq "double"
+  end
+end
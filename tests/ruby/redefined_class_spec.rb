@@ -0,0 +1,34 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+
+describe "Redefined Yast classes" do
+  # a new process, the redefined constant would leak into other specs
+  def run(code)
+    # require_relative does not work in -e
+    helper = $LOADED_FEATURES.grep(/test_helper/).first
+    script = <<-EOS
+      load '#{helper}'
+      require 'yast'
+      def echo(value)
+        Yast::WFM.CallFunction('echo_client', [value])
+      end
+      #{code}
+    EOS
+    IO.popen(["ruby", "-e", script], &:read)
+  end
+
+  it "converts to the class the constant points to now" do
+    result = run(<<-EOS)
+      old = echo(Yast::Path.new('.old')).class
+      Yast.send(:remove_const, :Path)
+      load 'yast/path.rb'
+      res = echo([Yast::Path.new('.new')])
+      print res.first.class.equal?(Yast::Path) && !old.equal?(Yast::Path)
+    EOS
+
+    expect(result).to eq "true"
+  end
+end
@@ -0,0 +1,40 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+require "tmpdir"
+
+describe "Yast.shared_conversion" do
+  around do |example|
+    Dir.mktmpdir do |dir|
+      @file = File.join(dir, "value.ycp")
+      example.run
+    end
+  end
+
+  def round_trip(value)
+    Yast::SCR.Write(Yast::Path.new(".target.ycp"), @file, value)
+    Yast::SCR.Read(Yast::Path.new(".target.ycp"), @file)
+  end
+
+  it "converts shared values same as the default conversion" do
+    defaults = { "size" => 0, "name" => "disk" }
+    list = Array.new(10) { defaults }
+
+    expect(Yast.shared_conversion { round_trip(list) }).to eq round_trip(list)
+  end
+
+  it "raises RuntimeError for cyclic structures" do
+    list = [1, 2]
+    list << { "self" => list }
+
+    expect { Yast.shared_conversion { round_trip(list) } }
+      .to raise_error(RuntimeError, /Cyclic/)
+  end
+
+  it "restores the default conversion after the block" do
+    expect { Yast.shared_conversion { raise "failed" } }.to raise_error("failed")
+    expect(Yast.instance_variable_get(:@__shared_conversion)).to be_nil
+  end
+end
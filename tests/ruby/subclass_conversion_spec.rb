@@ -0,0 +1,48 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+require "tmpdir"
+
+module Yast
+  class SubclassSpecPath < Path; end
+  class SubclassSpecTerm < Term; end
+  class SubclassSpecFunRef < FunRef; end
+  class SubclassSpecByteblock < Byteblock; end
+  class SubclassSpecArgRef < ArgRef; end
+end
+
+describe "Conversion of subclasses" do
+  def echo(value)
+    Yast::WFM.CallFunction("echo_client", [value])
+  end
+
+  it "converts a Path subclass like a Path" do
+    expect(echo(Yast::SubclassSpecPath.new(".etc.fstab"))).to eq Yast::Path.new(".etc.fstab")
+  end
+
+  it "converts a Term subclass like a Term" do
+    term = Yast::SubclassSpecTerm.new(:Label, "text")
+    expect(echo([term])).to eq [Yast::Term.new(:Label, "text")]
+  end
+
+  it "converts a FunRef subclass like a FunRef" do
+    ref = Yast::SubclassSpecFunRef.new(proc { |a| a + 1 }, "integer (integer)")
+    expect(echo(ref)).to be_a Yast::YReference
+  end
+
+  it "converts a Byteblock subclass like a Byteblock" do
+    Dir.mktmpdir do |dir|
+      file = File.join(dir, "data.bin")
+      data = (0..255).map(&:chr).join
+      Yast::SCR.Write(Yast::Path.new(".target.byte"), file, Yast::SubclassSpecByteblock.new(data))
+      expect(File.binread(file)).to eq data.b
+    end
+  end
+
+  it "passes an ArgRef subclass by reference like an ArgRef" do
+    site = Yast.call_site("RefTestModule", :touch)
+    expect(site.call(__FILE__, __LINE__, Yast::SubclassSpecArgRef.new("value"))).to eq true
+  end
+end
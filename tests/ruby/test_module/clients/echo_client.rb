@@ -0,0 +1,3 @@
+# Returns its first argument, so the value passes the conversions
+# in both directions on the way
+Yast::WFM.Args.first
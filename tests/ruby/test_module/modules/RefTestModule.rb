@@ -0,0 +1,14 @@
+require "yast"
+
+module Yast
+  # Ruby module with a function taking its parameter by reference
+  class RefTestModuleClass < Module
+    def touch(_value)
+      true
+    end
+
+    publish function: :touch, type: "boolean (string &)"
+  end
+
+  RefTestModule = RefTestModuleClass.new
+end
@@ -0,0 +1,22 @@
+require "yast"
+
+module Yast
+  # Ruby module with functions of declared types, each returns its argument
+  class TypedTestModuleClass < Module
+    def echo(value)
+      value
+    end
+
+    alias_method :echo_string, :echo
+    alias_method :echo_float, :echo
+    alias_method :echo_list, :echo
+    alias_method :echo_map, :echo
+
+    publish function: :echo_string, type: "string (string)"
+    publish function: :echo_float, type: "float (float)"
+    publish function: :echo_list, type: "list <string> (list <string>)"
+    publish function: :echo_map, type: "map <string, integer> (map <string, integer>)"
+  end
+
+  TypedTestModule = TypedTestModuleClass.new
+end
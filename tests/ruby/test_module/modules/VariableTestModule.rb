@@ -0,0 +1,32 @@
+require "yast"
+
+module Yast
+  # Ruby module publishing variables with generated and custom accessors
+  class VariableTestModuleClass < Module
+    publish variable: :plain, type: "string"
+    publish variable: :custom, type: "string"
+    publish variable: :prepended, type: "string"
+
+    def initialize
+      @plain = "plain"
+      @custom = "custom"
+      @prepended = "prepended"
+    end
+
+    def custom
+      @custom.upcase
+    end
+
+    def custom=(value)
+      @custom = "#{value}!"
+    end
+
+    prepend(Module.new do
+      def prepended
+        "from prepended module"
+      end
+    end)
+  end
+
+  VariableTestModule = VariableTestModuleClass.new
+end
@@ -0,0 +1,14 @@
+require "yast"
+
+module Yast
+  # Ruby module stored in a file named by the rails convention
+  class DelimTestModuleClass < Module
+    def file_name
+      "delim_test_module"
+    end
+
+    publish function: :file_name, type: "string ()"
+  end
+
+  DelimTestModule = DelimTestModuleClass.new
+end
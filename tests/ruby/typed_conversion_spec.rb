@@ -0,0 +1,41 @@
+#!/usr/bin/env rspec
+
+require_relative "test_helper"
+
+require "yast"
+
+describe "conversion by the declared types" do
+  # the functions of the Ruby module are called through the component
+  # system, the arguments and the result are converted by their types
+  def call(function, value)
+    Yast.call_site("TypedTestModule", function).call(__FILE__, __LINE__, value)
+  end
+
+  it "converts scalars of the declared type" do
+    expect(call(:echo_string, "text")).to eq "text"
+    expect(call(:echo_float, 1.5)).to eq 1.5
+    expect(call(:echo_string, nil)).to eq nil
+  end
+
+  it "converts lists and maps of scalars" do
+    expect(call(:echo_list, ["a", "b"])).to eq ["a", "b"]
+    expect(call(:echo_map, "a" => 1, "b" => 2)).to eq("a" => 1, "b" => 2)
+  end
+
+  it "converts a value not matching its type as usual" do
+    expect(call(:echo_float, 1)).to eq 1
+    expect(call(:echo_list, ["a", 1])).to eq ["a", 1]
+    expect(call(:echo_map, a: 1.5)).to eq(a: 1.5)
+  end
+
+  it "does not log a mismatch as an error" do
+    # the y2log of liby2util, errors are logged with the <3> level
+    log = Process.uid.zero? ? "/var/log/YaST2/y2log" : File.join(Dir.home, ".y2log")
+    call(:echo_float, 0.5)
+    logged = File.exist?(log) ? File.size(log) : 0
+
+    call(:echo_float, 1)
+    errors = File.exist?(log) ? IO.read(log, nil, logged).lines.grep(/ <3> /) : []
+    expect(errors).to be_empty
+  end
+end
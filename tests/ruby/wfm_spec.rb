@@ -3,6 +3,7 @@
 require_relative "test_helper"
 
 require "yast"
+require "tmpdir"
 
 module Yast
   describe WFM do
@@ -30,6 +31,39 @@ module Yast
       end
     end
 
+    describe ".run_client" do
+      let(:client) { File.join(Dir.mktmpdir, "compiled_client.rb") }
+
+      after { FileUtils.rm_rf(File.dirname(client)) }
+
+      it "runs the client again without changes" do
+        File.write(client, "[__FILE__, 42]")
+        2.times { expect(WFM.run_client(client)).to eq [client, 42] }
+      end
+
+      it "runs the modified client" do
+        File.write(client, "42")
+        expect(WFM.run_client(client)).to eq 42
+
+        File.write(client, "1043")
+        expect(WFM.run_client(client)).to eq 1043
+      end
+
+      it "runs the client replaced by another file" do
+        File.write(client, "42")
+        expect(WFM.run_client(client)).to eq 42
+
+        File.write(client + ".new", "43")
+        File.rename(client + ".new", client)
+        expect(WFM.run_client(client)).to eq 43
+      end
+
+      it "returns false for a client with a syntax error" do
+        File.write(client, "def")
+        expect(WFM.run_client(client)).to eq false
+      end
+    end
+
     describe ".scr_chrooted?" do
       it "returns false for local scr" do
         expect(WFM.scr_chrooted?).to eq false
@@ -3,6 +3,7 @@
 require_relative "test_helper"
 
 require "yast"
+require "tmpdir"
 
 describe Yast do
   describe ".include" do
@@ -46,4 +47,33 @@ describe Yast do
       expect { Yast.include(Class.new.new, "cyclic_yin.rb") }.not_to raise_error
     end
   end
+
+  describe ".find_include_file" do
+    around do |example|
+      Dir.mktmpdir do |dir|
+        @dir = dir
+        example.run
+      end
+    end
+
+    let(:include_file) { File.join(@dir, "cached_lookup.rb") }
+
+    it "remembers the found path" do
+      File.write(include_file, "")
+      Yast.add_include_path(@dir)
+
+      2.times { expect(Yast.find_include_file("cached_lookup.rb")).to eq include_file }
+    end
+
+    it "remembers a missing file until the search paths change" do
+      Yast.add_include_path(@dir)
+      expect { Yast.find_include_file("cached_lookup.rb") }.to raise_error(RuntimeError)
+
+      File.write(include_file, "")
+      expect { Yast.find_include_file("cached_lookup.rb") }.to raise_error(RuntimeError)
+
+      Yast.add_module_path(@dir)
+      expect(Yast.find_include_file("cached_lookup.rb")).to eq include_file
+    end
+  end
 end